@@ -0,0 +1,39 @@
+#include "arena.h"
+
+#include <cstring>
+
+Arena::Arena(size_t chunk_size) : chunk_size_(chunk_size) {}
+
+std::string_view Arena::Store(std::string_view str) {
+	if (str.empty()) {
+		return {};
+	};
+	if (str.size() > free_size_) {
+		if (str.size() > chunk_size_ / 4) {
+			//big string gets its own chunk, so free space of the current chunk is not wasted
+			chunks_.push_back(std::make_unique<char[]>(str.size()));
+			reserved_bytes_ += str.size();
+			used_bytes_ += str.size();
+			std::memcpy(chunks_.back().get(), str.data(), str.size());
+			return { chunks_.back().get(), str.size() };
+		};
+		chunks_.push_back(std::make_unique<char[]>(chunk_size_));
+		reserved_bytes_ += chunk_size_;
+		free_begin_ = chunks_.back().get();
+		free_size_ = chunk_size_;
+	};
+	char* stored = free_begin_;
+	std::memcpy(stored, str.data(), str.size());
+	free_begin_ += str.size();
+	free_size_ -= str.size();
+	used_bytes_ += str.size();
+	return { stored, str.size() };
+}
+
+size_t Arena::GetUsedBytes() const {
+	return used_bytes_;
+}
+
+size_t Arena::GetReservedBytes() const {
+	return reserved_bytes_;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+//bump allocator for strings: bytes are copied one after another into big chunks of memory,
+//so storing millions of small strings needs only a few allocations.
+//Memory is never freed separately, only all at once when the arena is destroyed,
+//views to stored strings stay valid until then, moving the arena does not invalidate them
+class Arena {
+public:
+	explicit Arena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+	Arena(const Arena&) = delete;
+
+	Arena& operator=(const Arena&) = delete;
+
+	Arena(Arena&&) = default;
+
+	Arena& operator=(Arena&&) = default;
+
+	//copying bytes of the string into the arena, returns view of the copy
+	std::string_view Store(std::string_view str);
+
+	//amount of bytes of all stored strings
+	size_t GetUsedBytes() const;
+
+	//amount of bytes taken from the system
+	size_t GetReservedBytes() const;
+
+	static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+private:
+	size_t chunk_size_;
+	std::vector<std::unique_ptr<char[]>> chunks_;
+	char* free_begin_ = nullptr; //free space of the last chunk
+	size_t free_size_ = 0;
+	size_t used_bytes_ = 0;
+	size_t reserved_bytes_ = 0;
+};
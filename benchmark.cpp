@@ -0,0 +1,322 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "search_server.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+
+namespace {
+	//collecting durations of timed calls of one benchmark
+	class BenchmarkTimer {
+	public:
+		template <typename Function>
+		void Measure(size_t item_count, Function func) {
+			const auto start_time = std::chrono::steady_clock::now();
+			func();
+			latencies_.push_back(std::chrono::steady_clock::now() - start_time);
+			item_count_ += item_count;
+		}
+
+		BenchmarkResult GetResult(const std::string& name) const {
+			BenchmarkResult result;
+			result.name = name;
+			result.call_count = latencies_.size();
+			result.item_count = item_count_;
+			if (latencies_.empty()) {
+				return result;
+			};
+			std::vector<std::chrono::steady_clock::duration> latencies = latencies_;
+			std::sort(latencies.begin(), latencies.end());
+			std::chrono::steady_clock::duration total{ 0 };
+			for (const auto latency : latencies) {
+				total += latency;
+			};
+			const auto to_microseconds = [](std::chrono::steady_clock::duration duration) {
+				return std::chrono::duration<double, std::micro>(duration).count();
+			};
+			result.total_seconds = std::chrono::duration<double>(total).count();
+			result.items_per_second = result.total_seconds > 0.0 ? item_count_ / result.total_seconds : 0.0;
+			result.p50_microseconds = to_microseconds(latencies[latencies.size() / 2]);
+			result.p99_microseconds = to_microseconds(latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)]);
+			result.peak_memory_kb = GetPeakMemoryUsage();
+			return result;
+		}
+
+	private:
+		std::vector<std::chrono::steady_clock::duration> latencies_;
+		size_t item_count_ = 0;
+	};
+
+	//RemoveDuplicates reports every removed document to std::cout, the report is dropped while the object lives
+	class CoutSilencer {
+	public:
+		CoutSilencer() : buffer_(std::cout.rdbuf(nullptr)) {}
+
+		~CoutSilencer() {
+			std::cout.rdbuf(buffer_);
+			std::cout.clear();
+		}
+
+	private:
+		std::streambuf* buffer_;
+	};
+
+	size_t ParseCount(const std::string& value) {
+		if (value.empty() || value.find_first_not_of("0123456789"s) != std::string::npos) {
+			throw std::invalid_argument("Invalid benchmark option value "s + value);
+		};
+		return std::stoull(value);
+	}
+
+	double ParseRatio(const std::string& value) {
+		size_t parsed_size = 0;
+		double ratio = 0.0;
+		try {
+			ratio = std::stod(value, &parsed_size);
+		}
+		catch (const std::exception&) {
+			throw std::invalid_argument("Invalid benchmark option value "s + value);
+		};
+		if (parsed_size != value.size() || ratio < 0.0) {
+			throw std::invalid_argument("Invalid benchmark option value "s + value);
+		};
+		return ratio;
+	}
+}
+
+BenchmarkOptions ParseBenchmarkOptions(const std::vector<std::string>& args) {
+	BenchmarkOptions options;
+	CorpusOptions& corpus = options.corpus;
+	const std::map<std::string, std::function<void(const std::string&)>> setters = {
+		{ "documents"s, [&corpus](const std::string& value) { corpus.document_count = ParseCount(value); } },
+		{ "min-document-words"s, [&corpus](const std::string& value) { corpus.min_document_words = ParseCount(value); } },
+		{ "max-document-words"s, [&corpus](const std::string& value) { corpus.max_document_words = ParseCount(value); } },
+		{ "vocabulary"s, [&corpus](const std::string& value) { corpus.vocabulary_size = ParseCount(value); } },
+		{ "zipf"s, [&corpus](const std::string& value) { corpus.zipf_exponent = ParseRatio(value); } },
+		{ "stop-words"s, [&corpus](const std::string& value) { corpus.stop_word_count = ParseCount(value); } },
+		{ "stop-word-ratio"s, [&corpus](const std::string& value) { corpus.stop_word_ratio = ParseRatio(value); } },
+		{ "duplicate-ratio"s, [&corpus](const std::string& value) { corpus.duplicate_ratio = ParseRatio(value); } },
+		{ "queries"s, [&corpus](const std::string& value) { corpus.query_count = ParseCount(value); } },
+		{ "min-query-words"s, [&corpus](const std::string& value) { corpus.min_query_words = ParseCount(value); } },
+		{ "max-query-words"s, [&corpus](const std::string& value) { corpus.max_query_words = ParseCount(value); } },
+		{ "minus-word-ratio"s, [&corpus](const std::string& value) { corpus.minus_word_ratio = ParseRatio(value); } },
+		{ "seed"s, [&corpus](const std::string& value) { corpus.seed = ParseCount(value); } },
+		{ "repetitions"s, [&options](const std::string& value) { options.repetitions = ParseCount(value); } },
+		{ "removed-ratio"s, [&options](const std::string& value) { options.removed_ratio = ParseRatio(value); } },
+		{ "format"s, [&options](const std::string& value) {
+			if (value != "json"s && value != "csv"s) {
+				throw std::invalid_argument("Invalid benchmark output format "s + value);
+			};
+			options.format = value == "json"s ? BenchmarkFormat::JSON : BenchmarkFormat::CSV;
+		} },
+	};
+	for (const std::string& arg : args) {
+		const size_t equal_pos = arg.find('=');
+		const auto setter = arg.substr(0, 2) == "--"s && equal_pos != std::string::npos
+			? setters.find(arg.substr(2, equal_pos - 2)) : setters.end();
+		if (setter == setters.end()) {
+			throw std::invalid_argument("Unknown benchmark option "s + arg);
+		};
+		setter->second(arg.substr(equal_pos + 1));
+	};
+	if (corpus.vocabulary_size == 0 || corpus.min_document_words > corpus.max_document_words
+		|| corpus.min_query_words == 0 || corpus.min_query_words > corpus.max_query_words) {
+		throw std::invalid_argument("Invalid benchmark corpus options"s);
+	};
+	return options;
+}
+
+std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkOptions& options) {
+	const Corpus corpus = GenerateCorpus(options.corpus);
+	const int document_count = static_cast<int>(corpus.documents.size());
+	std::vector<BenchmarkResult> results;
+
+	SearchServer server(corpus.stop_words);
+	{
+		BenchmarkTimer timer;
+		for (int id = 0; id < document_count; ++id) {
+			timer.Measure(1, [&]() { server.AddDocument(id, corpus.documents[id], corpus.statuses[id], corpus.ratings[id]); });
+		};
+		results.push_back(timer.GetResult("AddDocument"s));
+	}
+
+	{
+		BenchmarkTimer timer;
+		for (const std::string& query : corpus.queries) {
+			timer.Measure(1, [&]() { server.FindTopDocuments(query); });
+		};
+		results.push_back(timer.GetResult("FindTopDocuments/seq"s));
+	}
+
+	{
+		BenchmarkTimer timer;
+		for (const std::string& query : corpus.queries) {
+			timer.Measure(1, [&]() { server.FindTopDocuments(std::execution::par, query); });
+		};
+		results.push_back(timer.GetResult("FindTopDocuments/par"s));
+	}
+
+	{
+		//the same rare status is searched by filter pushed down into indexes and by opaque predicate
+		BenchmarkTimer filter_timer;
+		BenchmarkTimer predicate_timer;
+		const auto is_banned = [](int, DocumentStatus status, int) { return status == DocumentStatus::BANNED; };
+		for (const std::string& query : corpus.queries) {
+			filter_timer.Measure(1, [&]() { server.FindTopDocuments(query, DocumentStatus::BANNED); });
+			predicate_timer.Measure(1, [&]() { server.FindTopDocuments(query, is_banned); });
+		};
+		results.push_back(filter_timer.GetResult("FindTopDocuments/banned_filter"s));
+		results.push_back(predicate_timer.GetResult("FindTopDocuments/banned_predicate"s));
+	}
+
+	{
+		//kernels specialized for predicate passing all documents and for common status filter
+		//are compared with the same conditions given as opaque predicates
+		BenchmarkTimer any_timer;
+		BenchmarkTimer any_predicate_timer;
+		BenchmarkTimer actual_timer;
+		BenchmarkTimer actual_predicate_timer;
+		const auto is_any = [](int, DocumentStatus, int) { return true; };
+		const auto is_actual = [](int, DocumentStatus status, int) { return status == DocumentStatus::ACTUAL; };
+		for (const std::string& query : corpus.queries) {
+			//postings of the query are loaded into cache before measuring, otherwise the first variant is penalized
+			server.FindTopDocuments(query, AnyDocument());
+			any_timer.Measure(1, [&]() { server.FindTopDocuments(query, AnyDocument()); });
+			any_predicate_timer.Measure(1, [&]() { server.FindTopDocuments(query, is_any); });
+			actual_timer.Measure(1, [&]() { server.FindTopDocuments(query, DocumentStatus::ACTUAL); });
+			actual_predicate_timer.Measure(1, [&]() { server.FindTopDocuments(query, is_actual); });
+		};
+		results.push_back(any_timer.GetResult("FindTopDocuments/any"s));
+		results.push_back(any_predicate_timer.GetResult("FindTopDocuments/any_predicate"s));
+		results.push_back(actual_timer.GetResult("FindTopDocuments/actual_filter"s));
+		results.push_back(actual_predicate_timer.GetResult("FindTopDocuments/actual_predicate"s));
+	}
+
+	if (document_count > 0) {
+		BenchmarkTimer seq_timer;
+		BenchmarkTimer par_timer;
+		for (size_t i = 0; i < corpus.queries.size(); ++i) {
+			const int id = static_cast<int>(i % document_count);
+			seq_timer.Measure(1, [&]() { server.MatchDocument(std::execution::seq, corpus.queries[i], id); });
+			par_timer.Measure(1, [&]() { server.MatchDocument(std::execution::par, corpus.queries[i], id); });
+		};
+		results.push_back(seq_timer.GetResult("MatchDocument/seq"s));
+		results.push_back(par_timer.GetResult("MatchDocument/par"s));
+	};
+
+	{
+		//every query is matched with all documents by one call
+		BenchmarkTimer timer;
+		std::vector<DocumentMatch> matches;
+		for (size_t i = 0; i < std::min<size_t>(corpus.queries.size(), 100); ++i) {
+			timer.Measure(document_count, [&]() { server.MatchDocuments(corpus.queries[i], matches); });
+		};
+		results.push_back(timer.GetResult("MatchDocuments"s));
+	}
+
+	{
+		BenchmarkTimer timer;
+		for (size_t i = 0; i < options.repetitions; ++i) {
+			timer.Measure(corpus.queries.size(), [&]() { ProcessQueries(server, corpus.queries); });
+		};
+		results.push_back(timer.GetResult("ProcessQueries"s));
+	}
+
+	{
+		//documents are removed from a copy, so every benchmark starts from the same index
+		SearchServer changed = server;
+		const size_t removed_count = std::min<size_t>(document_count, static_cast<size_t>(document_count * options.removed_ratio));
+		BenchmarkTimer timer;
+		for (size_t i = 0; i < removed_count; ++i) {
+			const int id = static_cast<int>(i * document_count / removed_count);
+			timer.Measure(1, [&]() { changed.RemoveDocument(id); });
+		};
+		results.push_back(timer.GetResult("RemoveDocument"s));
+	}
+
+	{
+		BenchmarkTimer timer;
+		for (size_t i = 0; i < options.repetitions; ++i) {
+			SearchServer changed = server;
+			CoutSilencer silencer;
+			timer.Measure(document_count, [&]() { RemoveDuplicates(changed); });
+		};
+		results.push_back(timer.GetResult("RemoveDuplicates"s));
+	}
+
+	{
+		BenchmarkTimer timer;
+		for (size_t i = 0; i < options.repetitions; ++i) {
+			timer.Measure(document_count, [&]() { FindNearDuplicates(server); });
+		};
+		results.push_back(timer.GetResult("FindNearDuplicates"s));
+	}
+	return results;
+}
+
+void PrintBenchmarkResults(std::ostream& output, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results) {
+	if (options.format == BenchmarkFormat::CSV) {
+		output << "name,calls,items,seconds,items_per_second,p50_us,p99_us,peak_memory_kb"s << std::endl;
+		for (const BenchmarkResult& result : results) {
+			output << result.name << ',' << result.call_count << ',' << result.item_count << ',' << result.total_seconds << ','
+				<< result.items_per_second << ',' << result.p50_microseconds << ',' << result.p99_microseconds << ','
+				<< result.peak_memory_kb << std::endl;
+		};
+		return;
+	};
+
+	const CorpusOptions& corpus = options.corpus;
+	output << "{\n"s
+		<< "\t\"context\": {\n"s
+		<< "\t\t\"documents\": "s << corpus.document_count << ",\n"s
+		<< "\t\t\"document_words\": ["s << corpus.min_document_words << ", "s << corpus.max_document_words << "],\n"s
+		<< "\t\t\"vocabulary\": "s << corpus.vocabulary_size << ",\n"s
+		<< "\t\t\"zipf_exponent\": "s << corpus.zipf_exponent << ",\n"s
+		<< "\t\t\"queries\": "s << corpus.query_count << ",\n"s
+		<< "\t\t\"seed\": "s << corpus.seed << ",\n"s
+		<< "\t\t\"pool_workers\": "s << ThreadPool::GetDefault()->GetWorkerCount() << "\n"s
+		<< "\t},\n"s
+		<< "\t\"benchmarks\": [\n"s;
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& result = results[i];
+		output << "\t\t{ \"name\": \""s << result.name << "\", \"calls\": "s << result.call_count
+			<< ", \"items\": "s << result.item_count << ", \"seconds\": "s << result.total_seconds
+			<< ", \"items_per_second\": "s << result.items_per_second << ", \"p50_us\": "s << result.p50_microseconds
+			<< ", \"p99_us\": "s << result.p99_microseconds << ", \"peak_memory_kb\": "s << result.peak_memory_kb
+			<< (i + 1 < results.size() ? " },\n"s : " }\n"s);
+	};
+	output << "\t]\n}"s << std::endl;
+}
+
+size_t GetPeakMemoryUsage() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return 0;
+	};
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	};
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss) / 1024; //bytes on macOS
+#else
+	return static_cast<size_t>(usage.ru_maxrss); //kilobytes on Linux
+#endif
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "corpus_generator.h"
+
+enum class BenchmarkFormat {
+	JSON,
+	CSV,
+};
+
+struct BenchmarkOptions {
+	CorpusOptions corpus;
+	BenchmarkFormat format = BenchmarkFormat::JSON;
+	size_t repetitions = 3; //amount of calls of batch operations (ProcessQueries, RemoveDuplicates)
+	double removed_ratio = 0.1; //share of documents removed by RemoveDocument benchmark
+};
+
+//result of one benchmark, latencies are of single timed calls
+struct BenchmarkResult {
+	std::string name;
+	size_t call_count = 0;
+	size_t item_count = 0; //documents or queries processed by all calls
+	double total_seconds = 0.0;
+	double items_per_second = 0.0;
+	double p50_microseconds = 0.0;
+	double p99_microseconds = 0.0;
+	size_t peak_memory_kb = 0; //peak resident memory of the process after the benchmark
+};
+
+//parsing options of the form --name=value, e.g. --documents=100000 --format=csv.
+//Throws std::invalid_argument for unknown option or bad value
+BenchmarkOptions ParseBenchmarkOptions(const std::vector<std::string>& args);
+
+//generating corpus and measuring AddDocument, FindTopDocuments and MatchDocument (sequential and parallel), MatchDocuments,
+//ProcessQueries, RemoveDocument, RemoveDuplicates and FindNearDuplicates on it
+std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkOptions&);
+
+void PrintBenchmarkResults(std::ostream&, const BenchmarkOptions&, const std::vector<BenchmarkResult>&);
+
+//peak resident memory of the process in kilobytes, 0 if it can not be found
+size_t GetPeakMemoryUsage();
@@ -0,0 +1,109 @@
+#include "bit_packing.h"
+
+#include "platform.h"
+
+#ifdef SEARCH_SERVER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	const size_t LANE_COUNT = 4;
+
+	uint32_t LowBitsMask(unsigned bit_width) {
+		return bit_width >= 32 ? ~0u : (1u << bit_width) - 1;
+	}
+}
+
+unsigned RequiredBits(const uint32_t* values, size_t count) {
+	uint32_t all_bits = 0;
+	for (size_t i = 0; i < count; ++i) {
+		all_bits |= values[i];
+	};
+	return all_bits == 0 ? 0 : 32 - CountLeadingZeros(all_bits);
+}
+
+void PackBlock(const uint32_t* values, unsigned bit_width, uint32_t* packed) {
+	const uint32_t mask = LowBitsMask(bit_width);
+	for (size_t word = 0; word < bit_width * LANE_COUNT; ++word) {
+		packed[word] = 0;
+	};
+	for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+		for (size_t row = 0; row < PACKED_BLOCK_SIZE / LANE_COUNT; ++row) {
+			const uint32_t value = values[row * LANE_COUNT + lane] & mask;
+			const size_t bit = row * bit_width;
+			const unsigned offset = bit % 32;
+			packed[bit / 32 * LANE_COUNT + lane] |= value << offset;
+			if (offset + bit_width > 32) {
+				//value does not fit into the word, its upper bits go to the next word of the lane
+				packed[(bit / 32 + 1) * LANE_COUNT + lane] |= value >> (32 - offset);
+			};
+		};
+	};
+}
+
+void UnpackBlock(const uint32_t* packed, unsigned bit_width, uint32_t* values) {
+	if (bit_width == 0) {
+		for (size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+			values[i] = 0;
+		};
+		return;
+	};
+#ifdef SEARCH_SERVER_HAS_SSE2
+	//one row of 4 lanes is extracted at once, words of all lanes with the same index are loaded together
+	const __m128i mask = _mm_set1_epi32(static_cast<int>(LowBitsMask(bit_width)));
+	const __m128i* words = reinterpret_cast<const __m128i*>(packed);
+	size_t word = 0;
+	unsigned offset = 0;
+	__m128i current = _mm_loadu_si128(words);
+	for (size_t row = 0; row < PACKED_BLOCK_SIZE / LANE_COUNT; ++row) {
+		__m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(static_cast<int>(offset)));
+		offset += bit_width;
+		if (offset >= 32) {
+			offset -= 32;
+			++word;
+			if (word < bit_width) {
+				current = _mm_loadu_si128(words + word);
+				if (offset > 0) {
+					value = _mm_or_si128(value, _mm_sll_epi32(current, _mm_cvtsi32_si128(static_cast<int>(bit_width - offset))));
+				};
+			};
+		};
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(values + row * LANE_COUNT), _mm_and_si128(value, mask));
+	};
+#else
+	const uint32_t mask = LowBitsMask(bit_width);
+	for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+		for (size_t row = 0; row < PACKED_BLOCK_SIZE / LANE_COUNT; ++row) {
+			const size_t bit = row * bit_width;
+			const unsigned offset = bit % 32;
+			uint32_t value = packed[bit / 32 * LANE_COUNT + lane] >> offset;
+			if (offset + bit_width > 32) {
+				value |= packed[(bit / 32 + 1) * LANE_COUNT + lane] << (32 - offset);
+			};
+			values[row * LANE_COUNT + lane] = value & mask;
+		};
+	};
+#endif
+}
+
+void RestoreFromGaps(uint32_t* values, uint32_t previous) {
+#ifdef SEARCH_SERVER_HAS_SSE2
+	//prefix sums of 4 values are computed with two shifts, the last sum is carried to the next 4 values
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i carry = _mm_set1_epi32(static_cast<int>(previous));
+	for (size_t i = 0; i < PACKED_BLOCK_SIZE; i += LANE_COUNT) {
+		__m128i* block = reinterpret_cast<__m128i*>(values + i);
+		__m128i sums = _mm_add_epi32(_mm_loadu_si128(block), one);
+		sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 4));
+		sums = _mm_add_epi32(sums, _mm_slli_si128(sums, 8));
+		sums = _mm_add_epi32(sums, carry);
+		_mm_storeu_si128(block, sums);
+		carry = _mm_shuffle_epi32(sums, _MM_SHUFFLE(3, 3, 3, 3));
+	};
+#else
+	for (size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+		previous += values[i] + 1;
+		values[i] = previous;
+	};
+#endif
+}
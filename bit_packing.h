@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//amount of values in one packed block
+const size_t PACKED_BLOCK_SIZE = 128;
+
+//amount of bits needed to store the biggest of values, from 0 to 32
+unsigned RequiredBits(const uint32_t* values, size_t count);
+
+//packing PACKED_BLOCK_SIZE values into bit_width * 4 words, only lower bit_width bits of values are kept.
+//Values are spread over 4 lanes: value i goes to lane i % 4, every lane is a separate bit stream,
+//so unpacking extracts 4 values at once with one SIMD operation
+void PackBlock(const uint32_t* values, unsigned bit_width, uint32_t* packed);
+
+//unpacking PACKED_BLOCK_SIZE values packed by PackBlock, uses SSE2 when it is available
+void UnpackBlock(const uint32_t* packed, unsigned bit_width, uint32_t* values);
+
+//restoring increasing sequence from gaps in place: value i becomes value i - 1 + gap i + 1,
+//previous is the value before the first one. Works on PACKED_BLOCK_SIZE values, uses SSE2 when it is available
+void RestoreFromGaps(uint32_t* values, uint32_t previous);
@@ -0,0 +1,49 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(const SearchServer& server)
+	: current_(std::make_shared<SearchServer>(server)), standby_(std::make_shared<SearchServer>(server)),
+	is_current_released_(std::make_shared<std::atomic<bool>>(false)), published_(MakeHandle(current_, is_current_released_)) {}
+
+std::shared_ptr<const SearchServer> ConcurrentSearchServer::GetSnapshot() const {
+	return std::atomic_load(&published_);
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+	const std::vector<int>& ratings) {
+	Apply([&](SearchServer& server) {
+		server.AddDocument(document_id, document, status, ratings);
+		});
+}
+
+void ConcurrentSearchServer::AddDocuments(const std::vector<DocumentInput>& documents) {
+	Apply([&documents](SearchServer& server) {
+		server.AddDocuments(documents);
+		});
+}
+
+std::shared_ptr<const SearchServer> ConcurrentSearchServer::MakeHandle(std::shared_ptr<SearchServer> server,
+	std::shared_ptr<std::atomic<bool>> is_released) {
+	SearchServer* server_ptr = server.get();
+	return std::shared_ptr<const SearchServer>(server_ptr,
+		[server = std::move(server), is_released = std::move(is_released)](const SearchServer*) {
+			is_released->store(true, std::memory_order_release);
+		});
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+	Apply([document_id](SearchServer& server) {
+		server.RemoveDocument(document_id);
+		});
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+	Apply([&document_ids](SearchServer& server) {
+		server.RemoveDocuments(document_ids);
+		});
+}
+
+void ConcurrentSearchServer::MergeSegments() {
+	Apply([](SearchServer& server) {
+		server.MergeSegments();
+		});
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+//search server for reading and writing at the same time. Readers take snapshot of the published copy of the index
+//and search in it without any locks, the single writer changes the other copy and publishes it by atomic swap
+//of pointer. Writer never waits for readers: if the previous copy is already released, the same change is applied
+//to it and it becomes the next copy to change, otherwise it is left to its readers, the last of them destroys it,
+//and the next change is applied to new copy of the published one (copies share sealed segments of posting lists).
+//So searches are not blocked by adding and removing documents and every search sees a change completely
+//or does not see it at all. The price is memory for two copies of the index (three while old snapshot is held)
+//and applying every change twice
+class ConcurrentSearchServer {
+public:
+	explicit ConcurrentSearchServer(const SearchServer& server);
+
+	//current version of the index, it is not changed while it is held. Holding snapshot never blocks writers,
+	//even in the same thread, but while it is held the next change copies the published index instead of reusing
+	//the previous one
+	std::shared_ptr<const SearchServer> GetSnapshot() const;
+
+	//changing methods are executed one by one and throw the same exceptions as methods of SearchServer,
+	//if exception is thrown, nothing is changed
+	void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+	void AddDocuments(const std::vector<DocumentInput>& documents);
+
+	void RemoveDocument(int document_id);
+
+	void RemoveDocuments(const std::vector<int>& document_ids);
+
+	//merging segments of posting lists (see SearchServer::MergeSegments) while readers search in the published copy
+	void MergeSegments();
+
+private:
+	std::mutex writer_mutex_;
+	std::shared_ptr<SearchServer> current_; //published copy
+	std::shared_ptr<SearchServer> standby_; //copy which is changed by writer, readers never see it, null if it is not made yet
+	std::shared_ptr<std::atomic<bool>> is_current_released_; //set when the last reader releases published copy
+	std::shared_ptr<const SearchServer> published_; //handle for readers, it is read and replaced only by atomic operations
+
+	//handle of the copy for readers, the flag is set when the handle and all its copies are destroyed.
+	//Handle owns the copy too, so snapshots stay valid even after this object is destroyed
+	static std::shared_ptr<const SearchServer> MakeHandle(std::shared_ptr<SearchServer> server,
+		std::shared_ptr<std::atomic<bool>> is_released);
+
+	template <typename Change>
+	void Apply(Change change) {
+		std::lock_guard guard(writer_mutex_);
+		//previous copy was left to its readers, published copy is not changed while it is read, so it is copied
+		if (!standby_) {
+			standby_ = std::make_shared<SearchServer>(*current_);
+		};
+		change(*standby_);
+		auto is_released = std::make_shared<std::atomic<bool>>(false);
+		std::atomic_store(&published_, MakeHandle(standby_, is_released));
+		std::swap(current_, standby_);
+		std::swap(is_current_released_, is_released);
+
+		//new readers get the new copy. Previous one is changed only if nobody reads it,
+		//otherwise the handle of readers owns it and the last reader destroys it
+		if (is_released->load(std::memory_order_acquire)) {
+			change(*standby_);
+		}
+		else {
+			standby_.reset();
+		};
+	}
+};
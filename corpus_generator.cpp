@@ -0,0 +1,136 @@
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+	//standard engine gives the same sequence everywhere, while standard distributions may differ between libraries,
+	//so numbers of the needed ranges are made from its output directly
+	class Random {
+	public:
+		explicit Random(uint64_t seed) : engine_(seed) {}
+
+		//number in range [0, 1)
+		double NextDouble() {
+			return static_cast<double>(engine_() >> 11) * 0x1.0p-53;
+		}
+
+		//number in range [0, count)
+		size_t NextIndex(size_t count) {
+			return static_cast<size_t>(engine_() % count);
+		}
+
+		//number in range [min_value, max_value]
+		size_t NextInRange(size_t min_value, size_t max_value) {
+			return min_value + NextIndex(max_value - min_value + 1);
+		}
+
+	private:
+		std::mt19937_64 engine_;
+	};
+
+	//rank of word is found by binary search over cumulative probabilities
+	class ZipfSampler {
+	public:
+		ZipfSampler(size_t count, double exponent) : cumulative_(count) {
+			double sum = 0.0;
+			for (size_t rank = 0; rank < count; ++rank) {
+				sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+				cumulative_[rank] = sum;
+			};
+		}
+
+		size_t operator()(Random& random) const {
+			const double value = random.NextDouble() * cumulative_.back();
+			const size_t rank = std::upper_bound(cumulative_.begin(), cumulative_.end(), value) - cumulative_.begin();
+			return std::min(rank, cumulative_.size() - 1);
+		}
+
+	private:
+		std::vector<double> cumulative_;
+	};
+
+	//unique word of latin letters for every index
+	std::string MakeWord(size_t index) {
+		std::string word;
+		do {
+			word.push_back(static_cast<char>('a' + index % 26));
+			index /= 26;
+		} while (index > 0);
+		return word;
+	}
+
+	template <typename Container>
+	void Shuffle(Container& container, Random& random) {
+		for (size_t i = container.size(); i > 1; --i) {
+			std::swap(container[i - 1], container[random.NextIndex(i)]);
+		};
+	}
+}
+
+Corpus GenerateCorpus(const CorpusOptions& options) {
+	Random random(options.seed);
+	const ZipfSampler sampler(options.vocabulary_size, options.zipf_exponent);
+
+	//stop words get indexes after the vocabulary, so they never coincide with usual words
+	std::vector<std::string> vocabulary(options.vocabulary_size);
+	for (size_t rank = 0; rank < vocabulary.size(); ++rank) {
+		vocabulary[rank] = MakeWord(rank);
+	};
+	std::vector<std::string> stop_words(options.stop_word_count);
+	for (size_t i = 0; i < stop_words.size(); ++i) {
+		stop_words[i] = MakeWord(options.vocabulary_size + i);
+	};
+	const auto next_word = [&]() -> const std::string& {
+		if (!stop_words.empty() && random.NextDouble() < options.stop_word_ratio) {
+			return stop_words[random.NextIndex(stop_words.size())];
+		};
+		return vocabulary[sampler(random)];
+	};
+
+	Corpus corpus;
+	for (const std::string& word : stop_words) {
+		corpus.stop_words += corpus.stop_words.empty() ? word : " "s + word;
+	};
+
+	std::vector<std::vector<std::string>> document_words;
+	document_words.reserve(options.document_count);
+	for (size_t id = 0; id < options.document_count; ++id) {
+		std::vector<std::string> words;
+		if (id > 0 && random.NextDouble() < options.duplicate_ratio) {
+			//duplicate has the same set of words as some previous document
+			words = document_words[random.NextIndex(id)];
+			Shuffle(words, random);
+		}
+		else {
+			const size_t word_count = random.NextInRange(options.min_document_words, options.max_document_words);
+			for (size_t i = 0; i < word_count; ++i) {
+				words.push_back(next_word());
+			};
+		};
+		std::string text;
+		for (const std::string& word : words) {
+			text += text.empty() ? word : " "s + word;
+		};
+		corpus.documents.push_back(std::move(text));
+		corpus.statuses.push_back(random.NextIndex(16) == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL);
+		std::vector<int> ratings(random.NextInRange(1, 3));
+		for (int& rating : ratings) {
+			rating = static_cast<int>(random.NextIndex(21)) - 10;
+		};
+		corpus.ratings.push_back(std::move(ratings));
+		document_words.push_back(std::move(words));
+	};
+
+	for (size_t i = 0; i < options.query_count; ++i) {
+		const size_t word_count = random.NextInRange(options.min_query_words, options.max_query_words);
+		std::string query;
+		for (size_t j = 0; j < word_count; ++j) {
+			const bool is_minus = random.NextDouble() < options.minus_word_ratio;
+			query += (query.empty() ? ""s : " "s) + (is_minus ? "-"s + next_word() : next_word());
+		};
+		corpus.queries.push_back(std::move(query));
+	};
+	return corpus;
+}
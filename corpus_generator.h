@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "document.h"
+
+//parameters of synthetic corpus, the same parameters always give the same corpus on every platform
+struct CorpusOptions {
+	size_t document_count = 20000;
+	size_t min_document_words = 8;
+	size_t max_document_words = 32;
+	size_t vocabulary_size = 20000;
+	double zipf_exponent = 1.0; //word of rank r is taken with probability proportional to 1 / r^zipf_exponent
+	size_t stop_word_count = 10;
+	double stop_word_ratio = 0.1; //share of stop words among words of documents and queries
+	double duplicate_ratio = 0.05; //share of documents which repeat words of some previous document in another order
+	size_t query_count = 2000;
+	size_t min_query_words = 1;
+	size_t max_query_words = 4;
+	double minus_word_ratio = 0.1; //share of minus words among words of queries
+	uint64_t seed = 1;
+};
+
+struct Corpus {
+	std::string stop_words; //separated by spaces, as the constructor of SearchServer takes them
+	std::vector<std::string> documents; //id of document is its index
+	std::vector<DocumentStatus> statuses;
+	std::vector<std::vector<int>> ratings;
+	std::vector<std::string> queries;
+};
+
+//words of documents and queries are taken from vocabulary of generated words with Zipfian distribution,
+//so posting lists have realistic lengths: few very long ones and many short ones
+Corpus GenerateCorpus(const CorpusOptions&);
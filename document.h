@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <vector>
 
 using namespace std::string_literals;
 
@@ -18,6 +20,23 @@ enum class DocumentStatus {
 	REMOVED
 };
 
+//data of one document for adding many documents at once with SearchServer::AddDocuments,
+//text is not copied, so it must exist until adding is finished
+struct DocumentInput {
+	int id{0};
+	std::string_view text;
+	DocumentStatus status{DocumentStatus::ACTUAL};
+	std::vector<int> ratings;
+};
+
+//result of matching query with one document by SearchServer::MatchDocuments: plus words of the query
+//which are in the document, empty if the document has some minus word
+struct DocumentMatch {
+	int id{0};
+	std::vector<std::string_view> words;
+	DocumentStatus status{DocumentStatus::ACTUAL};
+};
+
 template <typename Ostream>
 Ostream& operator<<(Ostream& output, const Document& doc) {
 	output << "{ document_id = "s << doc.id << ", relevance = "s <<
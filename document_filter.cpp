@@ -0,0 +1,23 @@
+#include "document_filter.h"
+
+DocumentFilter::DocumentFilter(DocumentStatus status) {
+	SetStatuses({ status });
+}
+
+DocumentFilter& DocumentFilter::SetStatuses(std::initializer_list<DocumentStatus> statuses) {
+	status_mask_ = 0;
+	for (const DocumentStatus status : statuses) {
+		status_mask_ |= 1u << static_cast<int>(status);
+	};
+	return *this;
+}
+
+DocumentFilter& DocumentFilter::SetRatingRange(int min_rating, int max_rating) {
+	min_rating_ = min_rating;
+	max_rating_ = max_rating;
+	return *this;
+}
+
+std::string DocumentFilter::GetCacheKey() const {
+	return "filter "s + std::to_string(status_mask_) + " "s + std::to_string(min_rating_) + " "s + std::to_string(max_rating_);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <string>
+
+#include "document.h"
+
+const size_t DOCUMENT_STATUS_COUNT = 4;
+
+//declarative filter of documents by status and rating. Unlike opaque predicate it is known to the server,
+//so FindTopDocuments finds documents passing it by secondary indexes and skips postings of other documents
+//before scoring, and its results can be cached. It can be called as usual predicate too
+class DocumentFilter {
+public:
+	//filter passing all documents
+	DocumentFilter() = default;
+
+	//filter passing documents with the status
+	explicit DocumentFilter(DocumentStatus status);
+
+	//only documents with these statuses are passed
+	DocumentFilter& SetStatuses(std::initializer_list<DocumentStatus> statuses);
+
+	//only documents with rating in [min_rating, max_rating] are passed
+	DocumentFilter& SetRatingRange(int min_rating, int max_rating);
+
+	bool IsStatusAllowed(DocumentStatus status) const {
+		return (status_mask_ >> static_cast<int>(status)) & 1;
+	}
+
+	bool IsRatingAllowed(int rating) const {
+		return min_rating_ <= rating && rating <= max_rating_;
+	}
+
+	//bit of every allowed status is set, bit number is the status
+	uint32_t GetStatusMask() const {
+		return status_mask_;
+	}
+
+	//false if the filter passes any rating
+	bool HasRatingRange() const {
+		return min_rating_ != std::numeric_limits<int>::min() || max_rating_ != std::numeric_limits<int>::max();
+	}
+
+	int GetMinRating() const {
+		return min_rating_;
+	}
+
+	int GetMaxRating() const {
+		return max_rating_;
+	}
+
+	bool operator()(int, DocumentStatus status, int rating) const {
+		return IsStatusAllowed(status) && IsRatingAllowed(rating);
+	}
+
+	//key of results for query cache, equal filters have equal keys
+	std::string GetCacheKey() const;
+
+private:
+	static const uint32_t ALL_STATUSES = (1u << DOCUMENT_STATUS_COUNT) - 1;
+
+	uint32_t status_mask_ = ALL_STATUSES; //bit of every allowed status is set
+	int min_rating_ = std::numeric_limits<int>::min();
+	int max_rating_ = std::numeric_limits<int>::max();
+};
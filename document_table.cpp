@@ -0,0 +1,143 @@
+#include "document_table.h"
+
+#include <algorithm>
+
+DocumentTable::DocumentTable(std::vector<int> ids, std::vector<DocumentStatus> statuses, std::vector<int> ratings,
+	const std::vector<DocumentSlot>& live_slots)
+	: ids_(std::move(ids)), statuses_(std::move(statuses)), ratings_(std::move(ratings)),
+	removed_bits_((ids_.size() + 63) / 64, 0), status_codes_(ids_.size(), REMOVED_STATUS_CODE) {
+	for (DocumentSlot slot = 0; slot < ids_.size(); ++slot) {
+		removed_bits_[slot / 64] |= uint64_t{1} << (slot % 64);
+	};
+	for (const DocumentSlot slot : live_slots) {
+		id_to_slot_.emplace_hint(id_to_slot_.end(), ids_[slot], slot); //ids are sorted, so every insertion is constant
+		removed_bits_[slot / 64] &= ~(uint64_t{1} << (slot % 64));
+	};
+	//indexes are filled in order of slots, so every slot is appended
+	for (DocumentSlot slot = 0; slot < ids_.size(); ++slot) {
+		if (!IsRemoved(slot)) {
+			status_codes_[slot] = static_cast<uint8_t>(statuses_[slot]);
+			AddToIndexes(slot);
+		};
+	};
+}
+
+DocumentSlot DocumentTable::Add(int document_id, DocumentStatus status, int rating) {
+	const DocumentSlot slot = static_cast<DocumentSlot>(ids_.size());
+	id_to_slot_.emplace(document_id, slot);
+	ids_.push_back(document_id);
+	statuses_.push_back(status);
+	ratings_.push_back(rating);
+	status_codes_.push_back(static_cast<uint8_t>(status));
+	if (slot % 64 == 0) {
+		removed_bits_.push_back(0);
+	};
+	AddToIndexes(slot);
+	return slot;
+}
+
+void DocumentTable::Remove(int document_id) {
+	const auto iter = id_to_slot_.find(document_id);
+	if (iter == id_to_slot_.end()) {
+		return;
+	};
+	removed_bits_[iter->second / 64] |= uint64_t{1} << (iter->second % 64);
+	status_codes_[iter->second] = REMOVED_STATUS_CODE;
+	RemoveFromIndexes(iter->second);
+	id_to_slot_.erase(iter);
+}
+
+DocumentSlot DocumentTable::FindSlot(int document_id) const {
+	const auto iter = id_to_slot_.find(document_id);
+	return iter == id_to_slot_.end() ? NO_SLOT : iter->second;
+}
+
+bool DocumentTable::Contains(int document_id) const {
+	return id_to_slot_.count(document_id);
+}
+
+size_t DocumentTable::CountFilterUpperBound(const DocumentFilter& filter) const {
+	return std::min(CountStatuses(filter), CountRatingRange(filter));
+}
+
+std::vector<DocumentSlot> DocumentTable::FindSlots(const DocumentFilter& filter) const {
+	std::vector<DocumentSlot> slots;
+	const auto add_passed = [this, &filter, &slots](uint32_t slot) {
+		if (filter(ids_[slot], statuses_[slot], ratings_[slot])) {
+			slots.push_back(slot);
+		};
+	};
+	size_t bitmap_count = 0;
+	if (CountStatuses(filter) <= CountRatingRange(filter)) {
+		for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+			if (filter.IsStatusAllowed(static_cast<DocumentStatus>(status))) {
+				status_slots_[status].ForEach(add_passed);
+				++bitmap_count;
+			};
+		};
+	}
+	else {
+		for (auto iter = rating_slots_.lower_bound(filter.GetMinRating());
+			iter != rating_slots_.end() && iter->first <= filter.GetMaxRating(); ++iter) {
+			iter->second.ForEach(add_passed);
+			++bitmap_count;
+		};
+	};
+	//every bitmap gives slots in increasing order, but slots of different bitmaps are mixed
+	if (bitmap_count > 1) {
+		std::sort(slots.begin(), slots.end());
+	};
+	return slots;
+}
+
+size_t DocumentTable::size() const {
+	return id_to_slot_.size();
+}
+
+size_t DocumentTable::GetSlotCount() const {
+	return ids_.size();
+}
+
+DocumentTable::IdIterator DocumentTable::begin() const {
+	return IdIterator(id_to_slot_.begin());
+}
+
+DocumentTable::IdIterator DocumentTable::end() const {
+	return IdIterator(id_to_slot_.end());
+}
+
+void DocumentTable::AddToIndexes(DocumentSlot slot) {
+	status_slots_[static_cast<size_t>(statuses_[slot])].Add(slot);
+	rating_slots_[ratings_[slot]].Add(slot);
+}
+
+void DocumentTable::RemoveFromIndexes(DocumentSlot slot) {
+	status_slots_[static_cast<size_t>(statuses_[slot])].Remove(slot);
+	const auto iter = rating_slots_.find(ratings_[slot]);
+	iter->second.Remove(slot);
+	if (iter->second.empty()) {
+		rating_slots_.erase(iter);
+	};
+}
+
+size_t DocumentTable::CountStatuses(const DocumentFilter& filter) const {
+	size_t count = 0;
+	for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+		if (filter.IsStatusAllowed(static_cast<DocumentStatus>(status))) {
+			count += status_slots_[status].size();
+		};
+	};
+	return count;
+}
+
+size_t DocumentTable::CountRatingRange(const DocumentFilter& filter) const {
+	if (!filter.HasRatingRange()) {
+		return size();
+	};
+	size_t count = 0;
+	for (auto iter = rating_slots_.lower_bound(filter.GetMinRating());
+		iter != rating_slots_.end() && iter->first <= filter.GetMaxRating(); ++iter) {
+		count += iter->second.size();
+	};
+	return count;
+}
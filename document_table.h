@@ -0,0 +1,145 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "document.h"
+#include "document_filter.h"
+#include "slot_bitmap.h"
+
+using DocumentSlot = uint32_t;
+
+const DocumentSlot NO_SLOT = std::numeric_limits<DocumentSlot>::max();
+
+//dense table of documents data: every document gets internal slot number and
+//its id, status and rating are stored in parallel arrays indexed by slot,
+//so reading them while scanning posting lists is a simple array access.
+//Slots are given in growing order and are not reused after removing,
+//thanks to this posting lists of new documents are always appended to the end.
+//Slots of removed documents are marked in tombstone bitmap, so postings of removed documents
+//can stay in posting lists until they are merged.
+//Slots of not removed documents are also indexed by status and by rating, so documents passing DocumentFilter
+//are found without reading data of all documents
+class DocumentTable {
+public:
+	//iterator over ids of documents in increasing order
+	class IdIterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = int;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const int*;
+		using reference = const int&;
+
+		explicit IdIterator(std::map<int, DocumentSlot>::const_iterator iter) : iter_(iter) {}
+
+		reference operator*() const {
+			return iter_->first;
+		}
+
+		IdIterator& operator++() {
+			++iter_;
+			return *this;
+		}
+
+		IdIterator operator++(int) {
+			IdIterator copy = *this;
+			++iter_;
+			return copy;
+		}
+
+		bool operator==(const IdIterator& other) const {
+			return iter_ == other.iter_;
+		}
+
+		bool operator!=(const IdIterator& other) const {
+			return iter_ != other.iter_;
+		}
+
+	private:
+		std::map<int, DocumentSlot>::const_iterator iter_;
+	};
+
+	DocumentTable() = default;
+
+	//table with data of all slots given at once, live_slots are slots of not removed documents
+	//in increasing order of their ids
+	DocumentTable(std::vector<int> ids, std::vector<DocumentStatus> statuses, std::vector<int> ratings,
+		const std::vector<DocumentSlot>& live_slots);
+
+	//adding document which is not in the table yet, returns its slot
+	DocumentSlot Add(int document_id, DocumentStatus status, int rating);
+
+	//removing document from the table, its slot becomes empty and is marked as removed
+	void Remove(int document_id);
+
+	//returns slot of the document or NO_SLOT if there is no such document
+	DocumentSlot FindSlot(int document_id) const;
+
+	bool Contains(int document_id) const;
+
+	int GetId(DocumentSlot slot) const {
+		return ids_[slot];
+	}
+
+	DocumentStatus GetStatus(DocumentSlot slot) const {
+		return statuses_[slot];
+	}
+
+	int GetRating(DocumentSlot slot) const {
+		return ratings_[slot];
+	}
+
+	bool IsRemoved(DocumentSlot slot) const {
+		return (removed_bits_[slot / 64] >> (slot % 64)) & 1;
+	}
+
+	//code of slot which document is removed, it differs from codes of all statuses
+	static constexpr uint8_t REMOVED_STATUS_CODE = DOCUMENT_STATUS_COUNT;
+
+	//status codes indexed by slot: status of the document or REMOVED_STATUS_CODE, so one byte tells
+	//if document passes filter by statuses. The array is valid until the next adding of document
+	const uint8_t* GetStatusCodes() const {
+		return status_codes_.data();
+	}
+
+	//upper bound of amount of documents passed by the filter, it is taken from sizes of secondary indexes
+	size_t CountFilterUpperBound(const DocumentFilter& filter) const;
+
+	//slots of not removed documents passed by the filter in increasing order. Documents are taken from index
+	//of statuses or of ratings, the one giving less of them, and checked by the whole filter
+	std::vector<DocumentSlot> FindSlots(const DocumentFilter& filter) const;
+
+	//amount of documents in the table
+	size_t size() const;
+
+	//amount of given slots including empty ones, all slots are less than this number
+	size_t GetSlotCount() const;
+
+	IdIterator begin() const;
+
+	IdIterator end() const;
+
+private:
+	std::map<int, DocumentSlot> id_to_slot_;
+	std::vector<int> ids_;
+	std::vector<DocumentStatus> statuses_;
+	std::vector<int> ratings_;
+	std::vector<uint64_t> removed_bits_; //tombstone bitmap, bit of slot is set when its document is removed
+	std::vector<uint8_t> status_codes_; //status or REMOVED_STATUS_CODE of every slot, kept in sync with tombstones
+	std::array<SlotBitmap, DOCUMENT_STATUS_COUNT> status_slots_; //slots of not removed documents, index is status
+	std::map<int, SlotBitmap> rating_slots_; //slots of not removed documents by rating
+
+	void AddToIndexes(DocumentSlot slot);
+
+	void RemoveFromIndexes(DocumentSlot slot);
+
+	//amount of documents with status allowed by the filter
+	size_t CountStatuses(const DocumentFilter& filter) const;
+
+	//amount of documents with rating in range of the filter
+	size_t CountRatingRange(const DocumentFilter& filter) const;
+};
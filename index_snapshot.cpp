@@ -0,0 +1,160 @@
+#include "index_snapshot.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::string_literals;
+
+namespace {
+	uint64_t AlignOffset(uint64_t offset) {
+		return (offset + 7) / 8 * 8;
+	}
+}
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path) {
+	file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE) {
+		file_ = nullptr;
+		throw std::runtime_error("Can not open file "s + path);
+	};
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_, &file_size)) {
+		CloseHandle(file_);
+		throw std::runtime_error("Can not get size of file "s + path);
+	};
+	size_ = static_cast<size_t>(file_size.QuadPart);
+	if (size_ == 0) {
+		return; //empty file can not be mapped, but it is not an error here
+	};
+	mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_ != nullptr) {
+		data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	};
+	if (data_ == nullptr) {
+		if (mapping_ != nullptr) {
+			CloseHandle(mapping_);
+		};
+		CloseHandle(file_);
+		throw std::runtime_error("Can not map file "s + path);
+	};
+}
+
+MappedFile::~MappedFile() {
+	if (data_ != nullptr) {
+		UnmapViewOfFile(data_);
+		CloseHandle(mapping_);
+	};
+	if (file_ != nullptr) {
+		CloseHandle(file_);
+	};
+}
+#else
+MappedFile::MappedFile(const std::string& path) {
+	const int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("Can not open file "s + path);
+	};
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0) {
+		close(file);
+		throw std::runtime_error("Can not get size of file "s + path);
+	};
+	size_ = static_cast<size_t>(file_stat.st_size);
+	if (size_ > 0) {
+		void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED) {
+			close(file);
+			throw std::runtime_error("Can not map file "s + path);
+		};
+		data_ = static_cast<const char*>(data);
+	};
+	close(file); //mapping stays valid after the file is closed
+}
+
+MappedFile::~MappedFile() {
+	if (data_ != nullptr) {
+		munmap(const_cast<char*>(data_), size_);
+	};
+}
+#endif
+
+const char* MappedFile::data() const {
+	return data_;
+}
+
+size_t MappedFile::size() const {
+	return size_;
+}
+
+SnapshotLayout::SnapshotLayout(const SnapshotHeader& header) {
+	stop_words = AlignOffset(sizeof(SnapshotHeader));
+	term_offsets = AlignOffset(stop_words + header.stop_words_size);
+	term_bytes = AlignOffset(term_offsets + (header.term_count + 1) * sizeof(uint64_t));
+	posting_offsets = AlignOffset(term_bytes + header.term_bytes_size);
+	posting_slots = AlignOffset(posting_offsets + (header.term_count + 1) * sizeof(uint64_t));
+	posting_term_freqs = AlignOffset(posting_slots + header.posting_count * sizeof(uint32_t));
+	document_ids = AlignOffset(posting_term_freqs + header.posting_count * sizeof(double));
+	document_statuses = AlignOffset(document_ids + header.slot_count * sizeof(int32_t));
+	document_ratings = AlignOffset(document_statuses + header.slot_count * sizeof(int32_t));
+	live_slots = AlignOffset(document_ratings + header.slot_count * sizeof(int32_t));
+	forward_offsets = AlignOffset(live_slots + header.document_count * sizeof(uint32_t));
+	forward_term_ids = AlignOffset(forward_offsets + (header.slot_count + 1) * sizeof(uint64_t));
+	forward_term_freqs = AlignOffset(forward_term_ids + header.forward_count * sizeof(uint32_t));
+	file_size = forward_term_freqs + header.forward_count * sizeof(double);
+}
+
+SnapshotWriter::SnapshotWriter(const std::string& path)
+	: path_(path), temp_path_(path + ".tmp"s), output_(temp_path_, std::ios::binary | std::ios::trunc) {
+	if (!output_) {
+		throw std::runtime_error("Can not create file "s + temp_path_);
+	};
+}
+
+SnapshotWriter::~SnapshotWriter() {
+	if (output_.is_open()) {
+		output_.close();
+		std::error_code error;
+		std::filesystem::remove(temp_path_, error);
+	};
+}
+
+void SnapshotWriter::PadTo(uint64_t offset) {
+	if (offset < position_) {
+		throw std::logic_error("Snapshot section is bigger than expected"s);
+	};
+	const char zeros[8] = {};
+	while (position_ < offset) {
+		Write(zeros, static_cast<size_t>(std::min<uint64_t>(sizeof(zeros), offset - position_)));
+	};
+}
+
+void SnapshotWriter::Write(const void* data, size_t size) {
+	output_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	position_ += size;
+}
+
+void SnapshotWriter::Finish() {
+	output_.close();
+	if (!output_) {
+		throw std::runtime_error("Can not write snapshot file "s + temp_path_);
+	};
+	//renaming replaces the old file, but its memory stays mapped until all mappings of it are removed
+	std::error_code error;
+	std::filesystem::rename(temp_path_, path_, error);
+	if (error) {
+		std::filesystem::remove(temp_path_, error);
+		throw std::runtime_error("Can not replace snapshot file "s + path_);
+	};
+}
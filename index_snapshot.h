@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//read-only file mapped into memory, the mapping is removed when the object is destroyed
+class MappedFile {
+public:
+	//throws std::runtime_error if the file can not be opened or mapped
+	explicit MappedFile(const std::string& path);
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile();
+
+	const char* data() const;
+
+	size_t size() const;
+
+private:
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+#endif
+};
+
+//binary snapshot of the search server index. The file starts with this header, then sections follow
+//one after another, every section begins at offset aligned to 8 bytes:
+//stop words separated by spaces, term offsets and bytes, posting offsets, slots and term frequencies,
+//document ids, statuses, ratings and slots of live documents sorted by id,
+//forward index offsets, term ids and term frequencies.
+//Numbers are stored in native byte order, so arrays can be used right from the mapped memory
+struct SnapshotHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order; //SNAPSHOT_BYTE_ORDER written by the machine which created the file
+	uint64_t stop_words_size;
+	uint64_t term_count;
+	uint64_t term_bytes_size;
+	uint64_t posting_count;
+	uint64_t slot_count;
+	uint64_t document_count;
+	uint64_t forward_count;
+};
+
+const char SNAPSHOT_MAGIC[8] = { 'S', 'S', 'E', 'R', 'V', 'I', 'D', 'X' };
+
+const uint32_t SNAPSHOT_VERSION = 1;
+
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+//offsets of sections from the beginning of the file, they depend only on sizes from the header
+struct SnapshotLayout {
+	explicit SnapshotLayout(const SnapshotHeader& header);
+
+	uint64_t stop_words;
+	uint64_t term_offsets;
+	uint64_t term_bytes;
+	uint64_t posting_offsets;
+	uint64_t posting_slots;
+	uint64_t posting_term_freqs;
+	uint64_t document_ids;
+	uint64_t document_statuses;
+	uint64_t document_ratings;
+	uint64_t live_slots;
+	uint64_t forward_offsets;
+	uint64_t forward_term_ids;
+	uint64_t forward_term_freqs;
+	uint64_t file_size;
+};
+
+//sequential writer of snapshot sections, throws std::runtime_error if writing fails.
+//Bytes are written into temporary file which replaces the file at path only in Finish,
+//so servers which have the old file mapped keep working with its old contents
+class SnapshotWriter {
+public:
+	explicit SnapshotWriter(const std::string& path);
+
+	SnapshotWriter(const SnapshotWriter&) = delete;
+
+	SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+	//temporary file is removed if Finish was not called
+	~SnapshotWriter();
+
+	//writing zero bytes up to the offset where the next section begins
+	void PadTo(uint64_t offset);
+
+	void Write(const void* data, size_t size);
+
+	template <typename Value>
+	void WriteValue(const Value& value) {
+		Write(&value, sizeof(value));
+	}
+
+	template <typename Value>
+	void WriteArray(const std::vector<Value>& values) {
+		Write(values.data(), values.size() * sizeof(Value));
+	}
+
+	//closing temporary file and moving it to path, throws if any of written bytes did not reach it
+	void Finish();
+
+private:
+	std::string path_;
+	std::string temp_path_;
+	std::ofstream output_;
+	uint64_t position_ = 0;
+};
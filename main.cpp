@@ -7,6 +7,7 @@
 #include "test_example_functions.h"
 #include "remove_duplicates.h"
 #include "process_queries.h"
+#include "benchmark.h"
 
 using namespace std::string_literals;
 
@@ -17,7 +18,20 @@ void PrintDocument(const Document& document) {
 		<< "rating = "s << document.rating << " }"s << std::endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+	//benchmark mode: program --benchmark [--name=value ...], options are listed in ParseBenchmarkOptions
+	if (argc > 1 && argv[1] == "--benchmark"s) {
+		try {
+			const BenchmarkOptions options = ParseBenchmarkOptions(std::vector<std::string>(argv + 2, argv + argc));
+			PrintBenchmarkResults(std::cout, options, RunBenchmarks(options));
+		}
+		catch (const std::invalid_argument& e) {
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
 	{
 		TestSearchServer();
 		std::cout << "All tests OK"s << std::endl;
@@ -25,7 +39,9 @@ int main() {
 
 	{
 		SearchServer search_server("and in at"s);
-		RequestQueue request_queue(search_server);
+		//requests come once a minute, so the day window keeps the last 1440 of them
+		auto now = std::chrono::steady_clock::time_point();
+		RequestQueue request_queue(search_server, [&now] { return now; });
 
 		search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
 		search_server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, {1, 2, 3});
@@ -35,13 +51,17 @@ int main() {
 
 		// 1439 empty requests
 		for (int i = 0; i < 1439; ++i) {
+			now += std::chrono::minutes(1);
 			request_queue.AddFindRequest("empty request"s);
 		}
 		// still 1439 empty requests
+		now += std::chrono::minutes(1);
 		request_queue.AddFindRequest("curly dog"s);
 		// 1438 empty requests
+		now += std::chrono::minutes(1);
 		request_queue.AddFindRequest("big collar"s);
 		// 1437 empty requests
+		now += std::chrono::minutes(1);
 		request_queue.AddFindRequest("sparrow"s);
 		std::cout << "Total empty requests: "s << request_queue.GetNoResultRequests() << std::endl;
 	}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//SSE2 paths are compiled when it is available: GCC and Clang define __SSE2__, MSVC does not define it,
+//but every x64 target has SSE2 and x86 has it with /arch:SSE2 and higher
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCH_SERVER_HAS_SSE2
+#endif
+
+//index of the lowest set bit, value must not be 0
+inline unsigned CountTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
+//amount of zero bits above the highest set bit, value must not be 0
+inline unsigned CountLeadingZeros(uint32_t value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, value);
+	return 31 - static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_clz(value));
+#endif
+}
@@ -0,0 +1,349 @@
+#include "posting_list.h"
+
+namespace {
+	//delta part is merged when it is bigger than this constant plus 1/16 of segments and tail
+	const size_t MIN_DELTA_SIZE_TO_MERGE = 64;
+
+	bool CompareIds(const std::pair<DocumentSlot, double>& posting, DocumentSlot slot) {
+		return posting.first < slot;
+	}
+
+	//size tier of segment: 0 for segments smaller than TAIL_SIZE * MERGE_FACTOR, every next tier is MERGE_FACTOR times bigger
+	size_t GetSizeTier(size_t size) {
+		size_t tier = 0;
+		for (size_t bound = PostingList::TAIL_SIZE * PostingList::MERGE_FACTOR; size >= bound; bound *= PostingList::MERGE_FACTOR) {
+			++tier;
+		};
+		return tier;
+	}
+}
+
+PostingList::PostingList(const DocumentSlot* slots, const double* term_freqs, size_t size)
+	: max_term_freq_(size > 0 ? 1.0 : 0.0) { //frequency is never bigger than 1, exact maximum is found by merging
+	if (size > 0) {
+		segments_.push_back(PostingSegment::CreateExternal(slots, term_freqs, size));
+	};
+	UpdateSegmentsSize();
+}
+
+void PostingList::Add(DocumentSlot slot, double term_freq) {
+	max_term_freq_ = std::max(max_term_freq_, term_freq);
+	const DocumentSlot last_slot = GetLastMainSlot();
+	if (added_.empty() && removed_.empty() && (last_slot == NO_SLOT || last_slot < slot)) {
+		//most common case, slots are growing, so posting is just appended to the tail
+		slots_.push_back(slot);
+		term_freqs_.push_back(term_freq);
+		return;
+	};
+	const auto iter = std::lower_bound(added_.begin(), added_.end(), slot, CompareIds);
+	added_.insert(iter, { slot, term_freq });
+	MergeIfDeltaIsBig();
+}
+
+void PostingList::Remove(DocumentSlot slot) {
+	const auto added_iter = std::lower_bound(added_.begin(), added_.end(), slot, CompareIds);
+	if (added_iter != added_.end() && added_iter->first == slot) {
+		added_.erase(added_iter);
+		return;
+	};
+	if (!IsInMainPart(slot)) {
+		return;
+	};
+	const auto removed_iter = std::lower_bound(removed_.begin(), removed_.end(), slot);
+	if (removed_iter == removed_.end() || *removed_iter != slot) {
+		removed_.insert(removed_iter, slot);
+		MergeIfDeltaIsBig();
+	};
+}
+
+bool PostingList::Contains(DocumentSlot slot) const {
+	const auto added_iter = std::lower_bound(added_.begin(), added_.end(), slot, CompareIds);
+	if (added_iter != added_.end() && added_iter->first == slot) {
+		return true;
+	};
+	return IsInMainPart(slot) && !std::binary_search(removed_.begin(), removed_.end(), slot);
+}
+
+size_t PostingList::size() const {
+	return GetMainSize() - removed_.size() + added_.size();
+}
+
+bool PostingList::empty() const {
+	return size() == 0;
+}
+
+void PostingList::Merge(const RemovedSlots& is_removed) {
+	const bool is_merged = segments_.empty()
+		|| (segments_.size() == 1 && slots_.empty() && segments_.front()->IsCompressed() == is_compressed_);
+	if (added_.empty() && removed_.empty() && !is_removed && is_merged) {
+		return;
+	};
+	std::vector<DocumentSlot> slots;
+	std::vector<double> term_freqs;
+	slots.reserve(size());
+	term_freqs.reserve(size());
+	double max_term_freq = 0.0;
+	ForEach([&](DocumentSlot slot, double term_freq) {
+		if (is_removed && is_removed(slot)) {
+			return;
+		};
+		slots.push_back(slot);
+		term_freqs.push_back(term_freq);
+		max_term_freq = std::max(max_term_freq, term_freq);
+		});
+	max_term_freq_ = max_term_freq;
+	segments_.clear();
+	added_.clear();
+	removed_.clear();
+	if (!slots.empty() && (is_compressed_ || slots.size() >= TAIL_SIZE)) {
+		segments_.push_back(PostingSegment::Create(std::move(slots), std::move(term_freqs), is_compressed_));
+		slots_ = std::vector<DocumentSlot>();
+		term_freqs_ = std::vector<double>();
+	}
+	else {
+		slots_ = std::move(slots);
+		term_freqs_ = std::move(term_freqs);
+	};
+	UpdateSegmentsSize();
+}
+
+void PostingList::Compress(const RemovedSlots& is_removed) {
+	is_compressed_ = true;
+	Merge(is_removed);
+}
+
+bool PostingList::IsCompressed() const {
+	return is_compressed_;
+}
+
+bool PostingList::IsTailFull() const {
+	return slots_.size() >= TAIL_SIZE;
+}
+
+void PostingList::SealTail(const RemovedSlots& is_removed) {
+	if (!added_.empty() || !removed_.empty()) {
+		//tombstones and added postings can belong to any segment, so everything is merged
+		Merge(is_removed);
+		return;
+	};
+	std::vector<DocumentSlot> slots;
+	std::vector<double> term_freqs;
+	slots.reserve(slots_.size());
+	term_freqs.reserve(slots_.size());
+	for (size_t i = 0; i < slots_.size(); ++i) {
+		if (!is_removed || !is_removed(slots_[i])) {
+			slots.push_back(slots_[i]);
+			term_freqs.push_back(term_freqs_[i]);
+		};
+	};
+	slots_.clear();
+	term_freqs_.clear();
+	if (!slots.empty()) {
+		segments_.push_back(PostingSegment::Create(std::move(slots), std::move(term_freqs), is_compressed_));
+	};
+
+	//trailing segments of the same tier are merged, the result can get the next tier and be merged again
+	while (segments_.size() >= MERGE_FACTOR) {
+		const size_t tier = GetSizeTier(segments_.back()->size());
+		const bool is_same_tier = std::all_of(segments_.end() - MERGE_FACTOR, segments_.end(),
+			[tier](const auto& segment) { return GetSizeTier(segment->size()) == tier; });
+		if (!is_same_tier) {
+			break;
+		};
+		MergeLastSegments(MERGE_FACTOR, is_removed);
+	};
+	UpdateSegmentsSize();
+}
+
+size_t PostingList::GetSegmentCount() const {
+	return segments_.size();
+}
+
+double PostingList::GetMaxTermFreq() const {
+	return max_term_freq_;
+}
+
+size_t PostingList::GetMemoryUsage() const {
+	size_t bytes = slots_.capacity() * sizeof(DocumentSlot) + term_freqs_.capacity() * sizeof(double)
+		+ added_.capacity() * sizeof(added_.front()) + removed_.capacity() * sizeof(DocumentSlot)
+		+ segments_.capacity() * sizeof(segments_.front());
+	for (const auto& segment : segments_) {
+		if (!segment->IsExternal()) {
+			bytes += segment->GetMemoryUsage();
+		};
+	};
+	return bytes;
+}
+
+DocumentSlot PostingList::GetLastMainSlot() const {
+	if (!slots_.empty()) {
+		return slots_.back();
+	};
+	return segments_.empty() ? NO_SLOT : segments_.back()->GetLastSlot();
+}
+
+bool PostingList::IsInMainPart(DocumentSlot slot) const {
+	for (const auto& segment : segments_) {
+		if (slot <= segment->GetLastSlot()) {
+			return segment->Contains(slot);
+		};
+	};
+	return std::binary_search(slots_.begin(), slots_.end(), slot);
+}
+
+void PostingList::MergeIfDeltaIsBig() {
+	if (added_.size() + removed_.size() > MIN_DELTA_SIZE_TO_MERGE + GetMainSize() / 16) {
+		Merge();
+	};
+}
+
+void PostingList::MergeLastSegments(size_t count, const RemovedSlots& is_removed) {
+	size_t size = 0;
+	for (auto iter = segments_.end() - count; iter != segments_.end(); ++iter) {
+		size += (*iter)->size();
+	};
+	std::vector<DocumentSlot> slots;
+	std::vector<double> term_freqs;
+	slots.reserve(size);
+	term_freqs.reserve(size);
+	for (auto iter = segments_.end() - count; iter != segments_.end(); ++iter) {
+		(*iter)->ForEachInRange(0, NO_SLOT, [&](DocumentSlot slot, double term_freq) {
+			if (!is_removed || !is_removed(slot)) {
+				slots.push_back(slot);
+				term_freqs.push_back(term_freq);
+			};
+			});
+	};
+	segments_.resize(segments_.size() - count);
+	if (!slots.empty()) {
+		segments_.push_back(PostingSegment::Create(std::move(slots), std::move(term_freqs), is_compressed_));
+	};
+}
+
+void PostingList::UpdateSegmentsSize() {
+	segments_size_ = 0;
+	for (const auto& segment : segments_) {
+		segments_size_ += segment->size();
+	};
+}
+
+PostingList::Cursor::Cursor(const PostingList& postings) : postings_(&postings) {
+	LoadMain();
+	Settle();
+}
+
+void PostingList::Cursor::Next() {
+	if (slot_ == NO_SLOT) {
+		return;
+	};
+	if (is_added_current_) {
+		++added_index_;
+	}
+	else {
+		++index_;
+		LoadMain();
+	};
+	Settle();
+}
+
+void PostingList::Cursor::SeekTo(DocumentSlot slot) {
+	if (slot_ >= slot) {
+		return;
+	};
+	SeekMain(slot);
+	const auto& added = postings_->added_;
+	added_index_ = std::lower_bound(added.begin() + added_index_, added.end(), slot, CompareIds) - added.begin();
+	Settle();
+}
+
+void PostingList::Cursor::LoadMain() {
+	const PostingList& postings = *postings_;
+	const auto& segments = postings.segments_;
+	while (segment_ < segments.size() && index_ >= segments[segment_]->size()) {
+		NextSegment();
+	};
+	if (segment_ < segments.size()) {
+		const PostingSegment& segment = *segments[segment_];
+		if (segment.IsCompressed()) {
+			const size_t block = index_ / PACKED_BLOCK_SIZE;
+			if (block != decoded_block_) {
+				segment.DecodeBlock(block, block_slots_.data(), block_codes_.data());
+				decoded_block_ = block;
+			};
+			main_slot_ = block_slots_[index_ % PACKED_BLOCK_SIZE];
+			main_term_freq_ = segment.GetTermFreqByCode(block_codes_[index_ % PACKED_BLOCK_SIZE]);
+			return;
+		};
+		main_slot_ = segment.GetSlots()[index_];
+		main_term_freq_ = segment.GetTermFreqs()[index_];
+		return;
+	};
+	if (index_ >= postings.slots_.size()) {
+		main_slot_ = NO_SLOT;
+		return;
+	};
+	main_slot_ = postings.slots_[index_];
+	main_term_freq_ = postings.term_freqs_[index_];
+}
+
+void PostingList::Cursor::NextSegment() {
+	++segment_;
+	index_ = 0;
+	decoded_block_ = NO_BLOCK;
+}
+
+void PostingList::Cursor::SeekMain(DocumentSlot slot) {
+	if (main_slot_ >= slot) {
+		return;
+	};
+	const PostingList& postings = *postings_;
+	const auto& segments = postings.segments_;
+	//segments which end before the slot are skipped without reading them
+	while (segment_ < segments.size() && segments[segment_]->GetLastSlot() < slot) {
+		NextSegment();
+	};
+	if (segment_ < segments.size()) {
+		const PostingSegment& segment = *segments[segment_];
+		if (segment.IsCompressed()) {
+			//blocks are skipped without decoding, the slot can be only in the last block which starts not after it
+			const auto& first_slots = segment.GetBlockFirstSlots();
+			const size_t current_block = index_ / PACKED_BLOCK_SIZE;
+			const size_t block = std::upper_bound(first_slots.begin() + current_block, first_slots.end(), slot) - first_slots.begin();
+			if (block > current_block + 1) {
+				index_ = (block - 1) * PACKED_BLOCK_SIZE;
+			};
+			LoadMain();
+			while (main_slot_ < slot) {
+				++index_;
+				LoadMain();
+			};
+			return;
+		};
+		const DocumentSlot* slots = segment.GetSlots();
+		index_ = std::lower_bound(slots + index_, slots + segment.size(), slot) - slots;
+		LoadMain();
+		return;
+	};
+	const auto& slots = postings.slots_;
+	index_ = std::lower_bound(slots.begin() + std::min(index_, slots.size()), slots.end(), slot) - slots.begin();
+	LoadMain();
+}
+
+void PostingList::Cursor::Settle() {
+	const auto& removed = postings_->removed_;
+	while (main_slot_ != NO_SLOT) {
+		while (removed_index_ < removed.size() && removed[removed_index_] < main_slot_) {
+			++removed_index_;
+		};
+		if (removed_index_ < removed.size() && removed[removed_index_] == main_slot_) {
+			++index_; //posting was removed, skip it
+			LoadMain();
+			continue;
+		};
+		break;
+	};
+	const auto& added = postings_->added_;
+	is_added_current_ = added_index_ < added.size() && added[added_index_].first < main_slot_;
+	slot_ = is_added_current_ ? added[added_index_].first : main_slot_;
+	term_freq_ = is_added_current_ ? added[added_index_].second : main_term_freq_;
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "document_table.h"
+#include "posting_segment.h"
+
+//posting list of one word: slots of documents which contain the word and term frequencies in them.
+//The list is split like LSM tree: postings live in sealed immutable segments (PostingSegment) which follow each other
+//in increasing order of slots, new postings are appended to small mutable tail (two vectors, structure of arrays).
+//When the tail is full the owner seals it into a new segment, and trailing segments of the same size tier are merged
+//into one, so the list has O(log size) segments and every posting is rewritten O(log size) times.
+//Postings which can not be appended are collected in small delta part: sorted added postings and sorted tombstones
+//of removed postings of segments and tail. Delta part is merged when it becomes big enough.
+//Sealing and merging can drop postings of removed documents by predicate given by the owner
+class PostingList {
+public:
+	//predicate of slots of removed documents which postings are dropped while sealing and merging, can be empty
+	using RemovedSlots = std::function<bool(DocumentSlot)>;
+
+	//amount of postings in full tail
+	static constexpr size_t TAIL_SIZE = 4096;
+
+	//amount of segments of one size tier which are merged together
+	static constexpr size_t MERGE_FACTOR = 4;
+
+	PostingList() = default;
+
+	//list of one segment which postings are kept in external memory (e.g. mapped snapshot file) and are not copied,
+	//the memory must outlive the list and all its copies
+	PostingList(const DocumentSlot* slots, const double* term_freqs, size_t size);
+
+	//adding posting of document which is not in the list yet
+	void Add(DocumentSlot slot, double term_freq);
+
+	//removing posting of document, does nothing if there is no such document in the list
+	void Remove(DocumentSlot slot);
+
+	bool Contains(DocumentSlot slot) const;
+
+	//amount of postings including ones of removed documents which are not dropped yet
+	size_t size() const;
+
+	bool empty() const;
+
+	//merging all segments, tail and delta part into one segment (or into the tail for small list which is not compressed)
+	void Merge(const RemovedSlots& is_removed = {});
+
+	//making the list compressed: all postings are merged into one compressed segment
+	//and the following sealed segments are compressed too, frequencies are kept exactly
+	void Compress(const RemovedSlots& is_removed = {});
+
+	bool IsCompressed() const;
+
+	bool IsTailFull() const;
+
+	//moving postings of the tail into a new segment and merging trailing segments of the same size tier
+	void SealTail(const RemovedSlots& is_removed = {});
+
+	size_t GetSegmentCount() const;
+
+	//amount of memory taken by the list, segments kept in external memory are not counted
+	size_t GetMemoryUsage() const;
+
+	//upper bound of term frequencies of the list, it is exact after merging and is not decreased by removing
+	double GetMaxTermFreq() const;
+
+	//calling func(slot, term_freq) for every posting in increasing order of slots
+	template <typename Function>
+	void ForEach(Function func) const {
+		ForEachInRange(0, NO_SLOT, func);
+	}
+
+	//calling func(slot, term_freq) for postings with slots in range [begin_slot, end_slot)
+	//in increasing order of slots, beginning of the range is found with binary search
+	template <typename Function>
+	void ForEachInRange(DocumentSlot begin_slot, DocumentSlot end_slot, Function func) const {
+		if (added_.empty() && removed_.empty()) {
+			//fast path without delta part, simple linear pass over main part
+			ForEachMainInRange(begin_slot, end_slot, func);
+			return;
+		};
+
+		auto added_iter = std::lower_bound(added_.begin(), added_.end(), begin_slot,
+			[](const std::pair<DocumentSlot, double>& posting, DocumentSlot slot) { return posting.first < slot; });
+		auto removed_iter = std::lower_bound(removed_.begin(), removed_.end(), begin_slot);
+		ForEachMainInRange(begin_slot, end_slot, [&](DocumentSlot slot, double term_freq) {
+			while (added_iter != added_.end() && added_iter->first < slot) {
+				func(added_iter->first, added_iter->second);
+				++added_iter;
+			};
+			if (removed_iter != removed_.end() && *removed_iter == slot) {
+				++removed_iter; //posting was removed, skip it
+				return;
+			};
+			func(slot, term_freq);
+			});
+		for (; added_iter != added_.end() && added_iter->first < end_slot; ++added_iter) {
+			func(added_iter->first, added_iter->second);
+		};
+	}
+
+	//forward iterator over postings for document-at-a-time search, it can jump forward to the given slot
+	//skipping postings between (and whole segments and blocks of compressed segments). The list must not be changed while it is used
+	class Cursor {
+	public:
+		explicit Cursor(const PostingList& postings);
+
+		//slot of the current posting or NO_SLOT if all postings are passed
+		DocumentSlot GetSlot() const {
+			return slot_;
+		}
+
+		double GetTermFreq() const {
+			return term_freq_;
+		}
+
+		void Next();
+
+		//moving to the first posting with slot not less than the given one, cursor never moves back
+		void SeekTo(DocumentSlot slot);
+
+	private:
+		const PostingList* postings_;
+		//current posting of segments and tail, segment index equal to amount of segments means the tail
+		size_t segment_ = 0;
+		size_t index_ = 0;
+		DocumentSlot main_slot_ = NO_SLOT;
+		double main_term_freq_ = 0.0;
+		//positions in delta part
+		size_t added_index_ = 0;
+		size_t removed_index_ = 0;
+		bool is_added_current_ = false;
+		DocumentSlot slot_ = NO_SLOT;
+		double term_freq_ = 0.0;
+		//decoded block of current compressed segment
+		size_t decoded_block_ = NO_BLOCK;
+		alignas(16) std::array<uint32_t, PACKED_BLOCK_SIZE> block_slots_;
+		alignas(16) std::array<uint32_t, PACKED_BLOCK_SIZE> block_codes_;
+
+		static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+
+		//reading posting at index_ of current segment or tail, passed segments are left
+		void LoadMain();
+
+		//moving to the next segment or to the tail
+		void NextSegment();
+
+		void SeekMain(DocumentSlot slot);
+
+		//skipping removed postings of segments and tail and choosing the current posting from them and added ones
+		void Settle();
+	};
+
+private:
+	std::vector<std::shared_ptr<const PostingSegment>> segments_;
+	size_t segments_size_ = 0; //total amount of postings of segments
+
+	//mutable tail, its slots are bigger than slots of segments
+	std::vector<DocumentSlot> slots_;
+	std::vector<double> term_freqs_;
+
+	std::vector<std::pair<DocumentSlot, double>> added_; //sorted by slot
+	std::vector<DocumentSlot> removed_; //sorted slots of removed postings of segments and tail
+	double max_term_freq_ = 0.0;
+	bool is_compressed_ = false;
+
+	//calling func(slot, term_freq) for postings of segments and tail with slots in range [begin_slot, end_slot)
+	template <typename Function>
+	void ForEachMainInRange(DocumentSlot begin_slot, DocumentSlot end_slot, Function func) const {
+		for (const auto& segment : segments_) {
+			if (segment->GetFirstSlot() >= end_slot) {
+				return;
+			};
+			if (segment->GetLastSlot() >= begin_slot) {
+				segment->ForEachInRange(begin_slot, end_slot, func);
+			};
+		};
+		const size_t first = std::lower_bound(slots_.begin(), slots_.end(), begin_slot) - slots_.begin();
+		for (size_t i = first; i < slots_.size() && slots_[i] < end_slot; ++i) {
+			func(slots_[i], term_freqs_[i]);
+		};
+	}
+
+	size_t GetMainSize() const {
+		return segments_size_ + slots_.size();
+	}
+
+	//the biggest slot of segments and tail or NO_SLOT if they are empty
+	DocumentSlot GetLastMainSlot() const;
+
+	bool IsInMainPart(DocumentSlot) const;
+
+	void MergeIfDeltaIsBig();
+
+	//merging the given amount of trailing segments into one
+	void MergeLastSegments(size_t count, const RemovedSlots& is_removed);
+
+	void UpdateSegmentsSize();
+};
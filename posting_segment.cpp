@@ -0,0 +1,104 @@
+#include "posting_segment.h"
+
+std::shared_ptr<const PostingSegment> PostingSegment::Create(std::vector<DocumentSlot> slots, std::vector<double> term_freqs, bool is_compressed) {
+	std::shared_ptr<PostingSegment> segment(new PostingSegment());
+	segment->size_ = slots.size();
+	segment->first_slot_ = slots.front();
+	segment->last_slot_ = slots.back();
+	segment->slots_ = std::move(slots);
+	segment->term_freqs_ = std::move(term_freqs);
+	segment->slots_.shrink_to_fit();
+	segment->term_freqs_.shrink_to_fit();
+	segment->slots_data_ = segment->slots_.data();
+	segment->term_freqs_data_ = segment->term_freqs_.data();
+	if (is_compressed) {
+		segment->Compress();
+	};
+	return segment;
+}
+
+std::shared_ptr<const PostingSegment> PostingSegment::CreateExternal(const DocumentSlot* slots, const double* term_freqs, size_t size) {
+	std::shared_ptr<PostingSegment> segment(new PostingSegment());
+	segment->size_ = size;
+	segment->first_slot_ = slots[0];
+	segment->last_slot_ = slots[size - 1];
+	segment->slots_data_ = slots;
+	segment->term_freqs_data_ = term_freqs;
+	return segment;
+}
+
+bool PostingSegment::Contains(DocumentSlot slot) const {
+	if (slot < first_slot_ || slot > last_slot_) {
+		return false;
+	};
+	if (IsCompressed()) {
+		bool is_found = false;
+		ForEachInRange(slot, slot + 1, [&is_found](DocumentSlot, double) { is_found = true; });
+		return is_found;
+	};
+	return std::binary_search(slots_data_, slots_data_ + size_, slot);
+}
+
+size_t PostingSegment::GetMemoryUsage() const {
+	return sizeof(PostingSegment)
+		+ slots_.capacity() * sizeof(DocumentSlot)
+		+ term_freqs_.capacity() * sizeof(double)
+		+ block_first_slots_.capacity() * sizeof(DocumentSlot)
+		+ block_offsets_.capacity() * sizeof(uint32_t)
+		+ block_slot_bits_.capacity() * sizeof(uint8_t)
+		+ words_.capacity() * sizeof(uint32_t)
+		+ term_freq_values_.capacity() * sizeof(double);
+}
+
+size_t PostingSegment::DecodeBlock(size_t block, uint32_t* slots, uint32_t* codes) const {
+	const uint32_t* packed = words_.data() + block_offsets_[block];
+	const unsigned slot_bits = block_slot_bits_[block];
+	UnpackBlock(packed, slot_bits, slots);
+	RestoreFromGaps(slots, block_first_slots_[block] - 1);
+	UnpackBlock(packed + slot_bits * 4, code_bits_, codes);
+	return std::min(PACKED_BLOCK_SIZE, size_ - block * PACKED_BLOCK_SIZE);
+}
+
+void PostingSegment::Compress() {
+	term_freq_values_ = term_freqs_;
+	std::sort(term_freq_values_.begin(), term_freq_values_.end());
+	term_freq_values_.erase(std::unique(term_freq_values_.begin(), term_freq_values_.end()), term_freq_values_.end());
+	term_freq_values_.shrink_to_fit();
+	const uint32_t max_code = static_cast<uint32_t>(term_freq_values_.size() - 1);
+	code_bits_ = RequiredBits(&max_code, 1);
+
+	uint32_t gaps[PACKED_BLOCK_SIZE];
+	uint32_t codes[PACKED_BLOCK_SIZE];
+	uint32_t packed[PACKED_BLOCK_SIZE];
+	for (size_t begin = 0; begin < size_; begin += PACKED_BLOCK_SIZE) {
+		const size_t count = std::min(PACKED_BLOCK_SIZE, size_ - begin);
+		//gaps are stored minus one, so runs of consecutive slots take no bits at all
+		DocumentSlot previous = slots_[begin] - 1;
+		for (size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+			if (i < count) {
+				gaps[i] = slots_[begin + i] - previous - 1;
+				previous = slots_[begin + i];
+				codes[i] = static_cast<uint32_t>(std::lower_bound(term_freq_values_.begin(), term_freq_values_.end(),
+					term_freqs_[begin + i]) - term_freq_values_.begin());
+			}
+			else {
+				gaps[i] = 0;
+				codes[i] = 0;
+			};
+		};
+		const unsigned slot_bits = RequiredBits(gaps, count);
+		block_first_slots_.push_back(slots_[begin]);
+		block_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+		block_slot_bits_.push_back(static_cast<uint8_t>(slot_bits));
+		PackBlock(gaps, slot_bits, packed);
+		words_.insert(words_.end(), packed, packed + slot_bits * 4);
+		PackBlock(codes, code_bits_, packed);
+		words_.insert(words_.end(), packed, packed + code_bits_ * 4);
+	};
+	words_.shrink_to_fit();
+
+	slots_ = std::vector<DocumentSlot>();
+	term_freqs_ = std::vector<double>();
+	slots_data_ = nullptr;
+	term_freqs_data_ = nullptr;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "document_table.h"
+#include "bit_packing.h"
+
+//sealed sorted run of postings of one word, it is never changed after creation, so copies of posting lists share it.
+//Postings are kept either in two arrays (structure of arrays), own or in external memory, or compressed:
+//slots are stored as gaps bit-packed in blocks of PACKED_BLOCK_SIZE postings and term frequencies
+//as bit-packed codes of values from the table of distinct frequencies of the segment
+class PostingSegment {
+public:
+	//segment of the given postings sorted by slot, there must be at least one posting
+	static std::shared_ptr<const PostingSegment> Create(std::vector<DocumentSlot> slots, std::vector<double> term_freqs, bool is_compressed);
+
+	//segment which arrays are kept in external memory (e.g. mapped snapshot file) and are not copied,
+	//the memory must outlive the segment
+	static std::shared_ptr<const PostingSegment> CreateExternal(const DocumentSlot* slots, const double* term_freqs, size_t size);
+
+	PostingSegment(const PostingSegment&) = delete;
+	PostingSegment& operator=(const PostingSegment&) = delete;
+
+	size_t size() const {
+		return size_;
+	}
+
+	DocumentSlot GetFirstSlot() const {
+		return first_slot_;
+	}
+
+	DocumentSlot GetLastSlot() const {
+		return last_slot_;
+	}
+
+	bool IsCompressed() const {
+		return slots_data_ == nullptr;
+	}
+
+	bool IsExternal() const {
+		return slots_data_ != nullptr && slots_data_ != slots_.data();
+	}
+
+	bool Contains(DocumentSlot slot) const;
+
+	//amount of memory taken by the segment, arrays kept in external memory are not counted
+	size_t GetMemoryUsage() const;
+
+	//arrays of segment which is not compressed
+	const DocumentSlot* GetSlots() const {
+		return slots_data_;
+	}
+
+	const double* GetTermFreqs() const {
+		return term_freqs_data_;
+	}
+
+	//first slots of blocks of compressed segment, blocks are skipped by binary search over them
+	const std::vector<DocumentSlot>& GetBlockFirstSlots() const {
+		return block_first_slots_;
+	}
+
+	//decoding slots and frequency codes of the block of compressed segment into arrays of PACKED_BLOCK_SIZE values,
+	//returns amount of postings in the block
+	size_t DecodeBlock(size_t block, uint32_t* slots, uint32_t* codes) const;
+
+	double GetTermFreqByCode(uint32_t code) const {
+		return term_freq_values_[code];
+	}
+
+	//calling func(slot, term_freq) for postings with slots in range [begin_slot, end_slot) in increasing order of slots
+	template <typename Function>
+	void ForEachInRange(DocumentSlot begin_slot, DocumentSlot end_slot, Function func) const {
+		if (IsCompressed()) {
+			//the range begins in the last block which starts not after begin_slot
+			size_t block = std::upper_bound(block_first_slots_.begin(), block_first_slots_.end(), begin_slot) - block_first_slots_.begin();
+			block = block > 0 ? block - 1 : 0;
+			alignas(16) uint32_t slots[PACKED_BLOCK_SIZE];
+			alignas(16) uint32_t codes[PACKED_BLOCK_SIZE];
+			for (; block < block_first_slots_.size() && block_first_slots_[block] < end_slot; ++block) {
+				const size_t count = DecodeBlock(block, slots, codes);
+				for (size_t i = 0; i < count && slots[i] < end_slot; ++i) {
+					if (slots[i] >= begin_slot) {
+						func(slots[i], term_freq_values_[codes[i]]);
+					};
+				};
+			};
+			return;
+		};
+
+		const size_t first = std::lower_bound(slots_data_, slots_data_ + size_, begin_slot) - slots_data_;
+		for (size_t i = first; i < size_ && slots_data_[i] < end_slot; ++i) {
+			func(slots_data_[i], term_freqs_data_[i]);
+		};
+	}
+
+private:
+	size_t size_ = 0;
+	DocumentSlot first_slot_ = NO_SLOT;
+	DocumentSlot last_slot_ = NO_SLOT;
+
+	//arrays of not compressed segment, they point either to own vectors or to external memory,
+	//both are null for compressed segment
+	const DocumentSlot* slots_data_ = nullptr;
+	const double* term_freqs_data_ = nullptr;
+	std::vector<DocumentSlot> slots_;
+	std::vector<double> term_freqs_;
+
+	//compressed postings
+	std::vector<DocumentSlot> block_first_slots_;
+	std::vector<uint32_t> block_offsets_; //index of the first word of the block
+	std::vector<uint8_t> block_slot_bits_; //bit width of slot gaps of the block
+	unsigned code_bits_ = 0; //bit width of frequency codes, the same for all blocks
+	std::vector<uint32_t> words_;
+	std::vector<double> term_freq_values_; //sorted distinct frequencies, code is index in this table
+
+	PostingSegment() = default;
+
+	void Compress();
+};
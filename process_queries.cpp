@@ -4,9 +4,10 @@
 std::vector<std::vector<Document>> ProcessQueries(
 	const SearchServer& search_server, const std::vector<std::string>& queries) {
 	std::vector<std::vector<Document>> result(queries.size());
-	std::transform(std::execution::par, queries.begin(), queries.end(), result.begin(),
-		[&search_server](const std::string& query) { 
-			return search_server.FindTopDocuments(query); 
+	//queries are processed by the same pool as parallel methods of the server, so threads are not oversubscribed
+	search_server.GetThreadPool().ParallelFor(queries.size(),
+		[&search_server, &queries, &result](size_t index) {
+			result[index] = search_server.FindTopDocuments(queries[index]);
 		});
 	return result;
 }
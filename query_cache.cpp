@@ -0,0 +1,69 @@
+#include "query_cache.h"
+
+QueryCache::QueryCache(size_t capacity) : capacity_(capacity) {}
+
+QueryCache::QueryCache(const QueryCache& other) : capacity_(other.capacity_.load()) {}
+
+QueryCache& QueryCache::operator=(const QueryCache& other) {
+	if (this != &other) {
+		SetCapacity(other.capacity_.load());
+	};
+	return *this;
+}
+
+void QueryCache::SetCapacity(size_t capacity) {
+	std::lock_guard guard(mutex_);
+	capacity_ = capacity;
+	positions_.clear();
+	entries_.clear();
+}
+
+bool QueryCache::IsEnabled() const {
+	return capacity_ > 0;
+}
+
+std::optional<std::vector<Document>> QueryCache::Find(const std::string& key, uint64_t index_version) {
+	std::lock_guard guard(mutex_);
+	CheckVersion(index_version);
+	const auto iter = positions_.find(key);
+	if (iter == positions_.end()) {
+		++misses_;
+		return std::nullopt;
+	};
+	++hits_;
+	entries_.splice(entries_.begin(), entries_, iter->second); //list nodes are not moved, so views stay valid
+	return iter->second->second;
+}
+
+void QueryCache::Insert(const std::string& key, uint64_t index_version, const std::vector<Document>& documents) {
+	std::lock_guard guard(mutex_);
+	if (capacity_ == 0) {
+		return;
+	};
+	CheckVersion(index_version);
+	const auto iter = positions_.find(key);
+	if (iter != positions_.end()) {
+		//other thread has found the same results meanwhile
+		entries_.splice(entries_.begin(), entries_, iter->second);
+		return;
+	};
+	if (entries_.size() >= capacity_) {
+		positions_.erase(entries_.back().first);
+		entries_.pop_back();
+	};
+	entries_.emplace_front(key, documents);
+	positions_.emplace(entries_.front().first, entries_.begin());
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+	std::lock_guard guard(mutex_);
+	return { hits_, misses_, entries_.size() };
+}
+
+void QueryCache::CheckVersion(uint64_t index_version) {
+	if (index_version != index_version_) {
+		positions_.clear();
+		entries_.clear();
+		index_version_ = index_version;
+	};
+}
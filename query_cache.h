@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+struct QueryCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	size_t size = 0; //amount of cached results
+};
+
+//LRU cache of search results. All kept results belong to one version of the index: when Find or Insert
+//gets another version, all results are dropped, so changing the index invalidates the cache.
+//Methods are thread safe, searches running in parallel share one cache
+class QueryCache {
+public:
+	//cache with zero capacity is disabled and keeps nothing
+	explicit QueryCache(size_t capacity = 0);
+
+	//copy gets the same capacity but no results and no counters
+	QueryCache(const QueryCache&);
+
+	QueryCache& operator=(const QueryCache&);
+
+	//changing capacity drops all kept results
+	void SetCapacity(size_t);
+
+	bool IsEnabled() const;
+
+	//returns kept results for the key and marks them as recently used
+	std::optional<std::vector<Document>> Find(const std::string& key, uint64_t index_version);
+
+	//keeping results for the key, the least recently used ones are dropped when capacity is reached
+	void Insert(const std::string& key, uint64_t index_version, const std::vector<Document>& documents);
+
+	QueryCacheStats GetStats() const;
+
+private:
+	using Entry = std::pair<std::string, std::vector<Document>>;
+
+	mutable std::mutex mutex_;
+	std::atomic<size_t> capacity_;
+	uint64_t index_version_ = 0;
+	std::list<Entry> entries_; //the most recently used results are at the front
+	std::unordered_map<std::string_view, std::list<Entry>::iterator> positions_; //keys are views into entries_
+	uint64_t hits_ = 0;
+	uint64_t misses_ = 0;
+
+	//dropping all results if they belong to another version of the index, mutex must be locked
+	void CheckVersion(uint64_t index_version);
+};
@@ -1,22 +1,225 @@
 #include "remove_duplicates.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+	//fingerprint of set of word ids: sums of two different hashes of ids do not depend on order of words,
+	//so equal sets always have equal fingerprints and different sets have them with probability about 2^-128
+	struct Fingerprint {
+		uint64_t first = 0;
+		uint64_t second = 0;
+
+		bool operator<(const Fingerprint& other) const {
+			return std::pair(first, second) < std::pair(other.first, other.second);
+		}
+
+		bool operator==(const Fingerprint& other) const {
+			return first == other.first && second == other.second;
+		}
+	};
+
+	//finalizer of splitmix64, it spreads close ids over all bits
+	uint64_t Mix(uint64_t value) {
+		value ^= value >> 30;
+		value *= 0xbf58476d1ce4e5b9ull;
+		value ^= value >> 27;
+		value *= 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+
+	Fingerprint ComputeFingerprint(const SearchServer& search_server, int document_id) {
+		Fingerprint fingerprint;
+		search_server.ForEachDocumentTermId(document_id, [&fingerprint](TermId term_id) {
+			fingerprint.first += Mix(term_id);
+			fingerprint.second += Mix(term_id + 0x9e3779b97f4a7c15ull);
+			});
+		return fingerprint;
+	}
+
+	std::vector<TermId> GetTermIds(const SearchServer& search_server, int document_id) {
+		std::vector<TermId> term_ids;
+		search_server.ForEachDocumentTermId(document_id, [&term_ids](TermId term_id) {
+			term_ids.push_back(term_id);
+			});
+		return term_ids;
+	}
+
+	//Jaccard similarity of sorted sets
+	double ComputeSimilarity(const std::vector<TermId>& lhs, const std::vector<TermId>& rhs) {
+		size_t common_count = 0;
+		for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end() && rhs_it != rhs.end();) {
+			if (*lhs_it < *rhs_it) {
+				++lhs_it;
+			}
+			else if (*rhs_it < *lhs_it) {
+				++rhs_it;
+			}
+			else {
+				++common_count;
+				++lhs_it;
+				++rhs_it;
+			};
+		};
+		const size_t union_count = lhs.size() + rhs.size() - common_count;
+		return union_count == 0 ? 1.0 : static_cast<double>(common_count) / union_count;
+	}
+}
+
 void RemoveDuplicates(SearchServer& search_server){
-	std::map<std::set<std::string_view>, int> documents_words_sets;
-	std::set<int> ids_to_delete;
-	for (const int id : search_server){
-		auto words_for_document = search_server.GetWordFrequencies(id);
-		std::set<std::string_view> words;
-		for (const auto& [word, _] : words_for_document){
-			words.insert(word);
-		};
-		if (!documents_words_sets.count(words)){
-			documents_words_sets[words] = id;
-		} else {
-			ids_to_delete.insert(id);
+	const std::vector<int> document_ids(search_server.begin(), search_server.end());
+	std::vector<std::pair<Fingerprint, int>> fingerprints(document_ids.size());
+	std::transform(std::execution::par, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+		[&search_server](int document_id) {
+			return std::pair(ComputeFingerprint(search_server, document_id), document_id);
+		});
+	//documents with equal fingerprints become neighbours in order of ids
+	std::sort(std::execution::par, fingerprints.begin(), fingerprints.end());
+
+	std::vector<int> ids_to_delete;
+	for (auto group_begin = fingerprints.begin(); group_begin != fingerprints.end();) {
+		const auto group_end = std::find_if(group_begin, fingerprints.end(),
+			[&group_begin](const auto& fingerprint) { return !(fingerprint.first == group_begin->first); });
+		if (group_end - group_begin > 1) {
+			//fingerprints can collide, so words are compared, the first document of every distinct set is kept
+			std::vector<std::vector<TermId>> kept_term_ids;
+			for (auto it = group_begin; it != group_end; ++it) {
+				std::vector<TermId> term_ids = GetTermIds(search_server, it->second);
+				if (std::find(kept_term_ids.begin(), kept_term_ids.end(), term_ids) != kept_term_ids.end()) {
+					ids_to_delete.push_back(it->second);
+				}
+				else {
+					kept_term_ids.push_back(std::move(term_ids));
+				};
+			};
 		};
+		group_begin = group_end;
 	};
+
+	std::sort(ids_to_delete.begin(), ids_to_delete.end());
+	search_server.RemoveDocuments(ids_to_delete);
 	for (const auto id : ids_to_delete){
-		search_server.RemoveDocument(id);
 		std::cout << "Found duplicate document id "s << id << std::endl;
 	};
 }
+
+namespace {
+	//all candidate pairs which similarity is not lower than the threshold, sorted by ids of documents and then
+	//by ids of originals
+	std::vector<NearDuplicate> FindSimilarPairs(const SearchServer& search_server, const NearDuplicateOptions& options) {
+		if (!(options.similarity_threshold > 0.0 && options.similarity_threshold <= 1.0)) {
+			throw std::invalid_argument("Similarity threshold must be in (0, 1]"s);
+		};
+		if (options.band_count == 0 || options.rows_per_band == 0) {
+			throw std::invalid_argument("Amounts of bands and rows must be positive"s);
+		};
+		const std::vector<int> document_ids(search_server.begin(), search_server.end());
+		const size_t signature_size = options.band_count * options.rows_per_band;
+
+		//value of the signature is the minimum of its hash over words of the document
+		std::vector<uint64_t> hash_seeds(signature_size);
+		for (size_t i = 0; i < signature_size; ++i) {
+			hash_seeds[i] = Mix(options.seed + (i + 1) * 0x9e3779b97f4a7c15ull);
+		};
+		std::vector<uint32_t> signatures(document_ids.size() * signature_size, std::numeric_limits<uint32_t>::max());
+		std::vector<char> has_words(document_ids.size(), false);
+		std::vector<size_t> indexes(document_ids.size());
+		std::iota(indexes.begin(), indexes.end(), 0);
+		std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](size_t index) {
+			uint32_t* const signature = signatures.data() + index * signature_size;
+			search_server.ForEachDocumentTermId(document_ids[index], [&](TermId term_id) {
+				for (size_t i = 0; i < signature_size; ++i) {
+					signature[i] = std::min(signature[i], static_cast<uint32_t>(Mix(term_id ^ hash_seeds[i])));
+				};
+				has_words[index] = true;
+				});
+			});
+
+		//documents with equal rows of the band get into one bucket, every document of the bucket becomes candidate
+		//with the first and the previous document of it, so amount of candidates is linear too
+		std::vector<std::pair<size_t, size_t>> candidates; //indexes of document and of document with smaller id
+		std::vector<std::pair<uint64_t, size_t>> band_keys;
+		band_keys.reserve(document_ids.size());
+		for (size_t band = 0; band < options.band_count; ++band) {
+			band_keys.clear();
+			for (size_t index = 0; index < document_ids.size(); ++index) {
+				if (!has_words[index]) {
+					continue;
+				};
+				const uint32_t* const rows = signatures.data() + index * signature_size + band * options.rows_per_band;
+				uint64_t key = band;
+				for (size_t row = 0; row < options.rows_per_band; ++row) {
+					key = Mix(key + rows[row]);
+				};
+				band_keys.push_back({ key, index });
+			};
+			std::sort(std::execution::par, band_keys.begin(), band_keys.end());
+			size_t first = 0; //first document of the current bucket
+			for (size_t i = 1; i < band_keys.size(); ++i) {
+				if (band_keys[i].first != band_keys[i - 1].first) {
+					first = i;
+					continue;
+				};
+				candidates.push_back({ band_keys[i].second, band_keys[i - 1].second });
+				if (first != i - 1) {
+					candidates.push_back({ band_keys[i].second, band_keys[first].second });
+				};
+			};
+		};
+		std::sort(std::execution::par, candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		std::vector<double> similarities(candidates.size());
+		std::transform(std::execution::par, candidates.begin(), candidates.end(), similarities.begin(),
+			[&](const std::pair<size_t, size_t>& candidate) {
+				return ComputeSimilarity(GetTermIds(search_server, document_ids[candidate.first]),
+					GetTermIds(search_server, document_ids[candidate.second]));
+			});
+
+		//indexes of documents increase with their ids, so sorted candidates are sorted by ids
+		std::vector<NearDuplicate> similar_pairs;
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			if (similarities[i] >= options.similarity_threshold) {
+				similar_pairs.push_back({ document_ids[candidates[i].first], document_ids[candidates[i].second], similarities[i] });
+			};
+		};
+		return similar_pairs;
+	}
+}
+
+std::vector<NearDuplicate> FindNearDuplicates(const SearchServer& search_server, const NearDuplicateOptions& options) {
+	//pairs are sorted, so the first similar one of every document has the smallest id
+	std::vector<NearDuplicate> near_duplicates;
+	for (const NearDuplicate& similar_pair : FindSimilarPairs(search_server, options)) {
+		if (near_duplicates.empty() || near_duplicates.back().document_id != similar_pair.document_id) {
+			near_duplicates.push_back(similar_pair);
+		};
+	};
+	return near_duplicates;
+}
+
+std::vector<NearDuplicate> RemoveNearDuplicates(SearchServer& search_server, const NearDuplicateOptions& options) {
+	//document is removed only if some kept document is similar to it, so in chain A ~ B ~ C where A and C are
+	//not similar only B is removed. Pairs are sorted by ids, so originals are resolved before their duplicates
+	std::vector<NearDuplicate> near_duplicates;
+	std::vector<int> ids_to_delete; //sorted because documents are resolved in order of ids
+	for (const NearDuplicate& similar_pair : FindSimilarPairs(search_server, options)) {
+		if ((!ids_to_delete.empty() && ids_to_delete.back() == similar_pair.document_id)
+			|| std::binary_search(ids_to_delete.begin(), ids_to_delete.end(), similar_pair.original_id)) {
+			continue;
+		};
+		near_duplicates.push_back(similar_pair);
+		ids_to_delete.push_back(similar_pair.document_id);
+	};
+	search_server.RemoveDocuments(ids_to_delete);
+	for (const auto id : ids_to_delete) {
+		std::cout << "Found near duplicate document id "s << id << std::endl;
+	};
+	return near_duplicates;
+}
@@ -1,9 +1,41 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <set>
-#include <map>
+#include <vector>
 
 #include "search_server.h"
 
+//removing documents which have the same set of words as some document with smaller id and reporting their ids.
+//Fingerprints of word sets are computed in parallel and only documents with equal fingerprints are compared
 void RemoveDuplicates(SearchServer&);
+
+//parameters of near duplicates search. Pair of documents becomes candidate with probability
+//1 - (1 - s^rows_per_band)^band_count where s is their similarity, defaults find 95% of pairs with similarity 0.8.
+//That is upper bound: to keep amount of candidates linear, every document of a band bucket is compared only with
+//the first and the previous documents of the bucket, so in bucket A, B, C, D pair of D and B is missed by this band.
+//Pairs in big buckets are found only if they meet closely in some band, small thresholds lose more of them
+struct NearDuplicateOptions {
+	double similarity_threshold = 0.8; //minimal Jaccard similarity of word sets, in (0, 1]
+	size_t band_count = 16;
+	size_t rows_per_band = 8;
+	uint64_t seed = 1;
+};
+
+struct NearDuplicate {
+	int document_id = 0;
+	int original_id = 0; //document with smaller id which is similar to this one
+	double similarity = 0.0; //Jaccard similarity of their word sets
+};
+
+//finding documents which word sets are similar to word set of some document with smaller id, in order of ids.
+//MinHash signatures are computed in parallel, documents with equal signature rows in some band become candidates
+//and their similarity is checked exactly. Memory is proportional to amount of documents, documents without words
+//are skipped. Throws std::invalid_argument for bad options
+std::vector<NearDuplicate> FindNearDuplicates(const SearchServer&, const NearDuplicateOptions& = {});
+
+//removing documents which are similar to some kept document with smaller id and reporting their ids, removed documents
+//are returned with the kept originals. Document which similar documents are all removed is kept, so in chain
+//A ~ B ~ C where A and C are not similar only B is removed
+std::vector<NearDuplicate> RemoveNearDuplicates(SearchServer&, const NearDuplicateOptions& = {});
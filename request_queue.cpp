@@ -1,6 +1,25 @@
 #include "request_queue.h"
 
-RequestQueue::RequestQueue(SearchServer& search_server) : search_server_(search_server){}
+#include <algorithm>
+
+#include "process_queries.h"
+
+namespace {
+	//lower bits of counter keep amount of requests, upper bits keep tag of bucket time.
+	//Tag is never 0, so zero counter does not belong to any time
+	const int COUNT_BITS = 40;
+	const uint64_t COUNT_MASK = (uint64_t{1} << COUNT_BITS) - 1;
+	const uint64_t TAG_PERIOD = (uint64_t{1} << (64 - COUNT_BITS)) - 1;
+
+	uint64_t GetTag(uint64_t bucket_time) {
+		return bucket_time % TAG_PERIOD + 1;
+	}
+}
+
+RequestQueue::RequestQueue(const SearchServer& search_server, Clock clock, size_t heavy_hitter_capacity)
+	: search_server_(search_server), clock_(std::move(clock)), heavy_hitter_capacity_(heavy_hitter_capacity) {
+	heavy_hitters_.reserve(heavy_hitter_capacity_);
+}
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
 	const auto search_result = search_server_.FindTopDocuments(raw_query, status);
@@ -14,16 +33,125 @@ std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
 	return search_result;
 }
 
+std::vector<std::vector<Document>> RequestQueue::AddFindRequests(const std::vector<std::string>& queries) {
+	auto search_results = ProcessQueries(search_server_, queries);
+	for (size_t i = 0; i < queries.size(); ++i) {
+		NewQuery(queries[i], search_results[i]);
+	};
+	return search_results;
+}
+
 int RequestQueue::GetNoResultRequests() const {
-	return static_cast<int>(count_if(begin(requests_), end(requests_),
-		[](const QueryResult& result) {return result.successful_search_ == false; }));
+	MoveWindow(GetBucketTime());
+	return static_cast<int>(std::max<int64_t>(0, window_no_result_requests_.load(std::memory_order_relaxed)));
+}
+
+int RequestQueue::GetRequestCount() const {
+	MoveWindow(GetBucketTime());
+	return static_cast<int>(std::max<int64_t>(0, window_requests_.load(std::memory_order_relaxed)));
+}
+
+double RequestQueue::GetNoResultRate() const {
+	MoveWindow(GetBucketTime());
+	const int64_t request_count = window_requests_.load(std::memory_order_relaxed);
+	if (request_count <= 0) {
+		return 0.0;
+	};
+	//requests added between two loads can make empty ones outnumber all
+	const int64_t no_result_count = std::max<int64_t>(0, window_no_result_requests_.load(std::memory_order_relaxed));
+	return std::min(1.0, static_cast<double>(no_result_count) / request_count);
+}
+
+std::vector<RequestQueue::HeavyHitter> RequestQueue::GetTopNoResultQueries(size_t count) const {
+	std::vector<HeavyHitter> result;
+	{
+		std::lock_guard guard(heavy_hitters_mutex_);
+		result = heavy_hitters_;
+	}
+	const auto is_more_frequent = [](const HeavyHitter& lhs, const HeavyHitter& rhs) {
+		return lhs.count > rhs.count || (lhs.count == rhs.count && lhs.query < rhs.query);
+	};
+	count = std::min(count, result.size());
+	std::partial_sort(result.begin(), result.begin() + count, result.end(), is_more_frequent);
+	result.resize(count);
+	return result;
 }
 
-void RequestQueue::NewQuery(const std::string& query, const std::vector<Document>& search_result){
-	bool success;
-	success = !search_result.empty() ? true : false;
-	if (requests_.size() >= sec_in_day_){
-		requests_.pop_front();
+bool RequestQueue::BucketCounter::Increment(uint64_t bucket_time) {
+	const uint64_t tag = GetTag(bucket_time);
+	uint64_t value = value_.load(std::memory_order_relaxed);
+	do {
+		if ((value >> COUNT_BITS) != tag) {
+			return false;
+		};
+	} while (!value_.compare_exchange_weak(value, value + 1, std::memory_order_relaxed));
+	return true;
+}
+
+uint64_t RequestQueue::BucketCounter::Start(uint64_t bucket_time) {
+	return value_.exchange(GetTag(bucket_time) << COUNT_BITS, std::memory_order_relaxed) & COUNT_MASK;
+}
+
+uint64_t RequestQueue::GetBucketTime() const {
+	const auto time = clock_().time_since_epoch();
+	return static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::minutes>(time) / BUCKET_DURATION));
+}
+
+void RequestQueue::MoveWindow(uint64_t bucket_time) const {
+	if (bucket_time < next_bucket_time_.load(std::memory_order_acquire)) {
+		return;
+	};
+	std::lock_guard guard(window_mutex_);
+	const uint64_t next_bucket_time = next_bucket_time_.load(std::memory_order_relaxed);
+	if (bucket_time < next_bucket_time) {
+		return;
 	};
-	requests_.push_back({query, success});
+	//after long pause only the last BUCKET_COUNT times are started, they cover the whole ring
+	const uint64_t begin_time = std::max(next_bucket_time, bucket_time + 1 - std::min<uint64_t>(BUCKET_COUNT, bucket_time + 1));
+	for (uint64_t time = begin_time; time <= bucket_time; ++time) {
+		Bucket& bucket = buckets_[time % BUCKET_COUNT];
+		window_requests_.fetch_sub(static_cast<int64_t>(bucket.requests.Start(time)), std::memory_order_relaxed);
+		window_no_result_requests_.fetch_sub(static_cast<int64_t>(bucket.no_result_requests.Start(time)),
+			std::memory_order_relaxed);
+	};
+	next_bucket_time_.store(bucket_time + 1, std::memory_order_release);
 }
+
+void RequestQueue::NewQuery(const std::string& query, const std::vector<Document>& search_result) {
+	const uint64_t bucket_time = GetBucketTime();
+	MoveWindow(bucket_time);
+	//every count which gets into bucket is added to totals once and subtracted once when the bucket expires
+	Bucket& bucket = buckets_[bucket_time % BUCKET_COUNT];
+	if (bucket.requests.Increment(bucket_time)) {
+		window_requests_.fetch_add(1, std::memory_order_relaxed);
+	};
+	if (search_result.empty()) {
+		if (bucket.no_result_requests.Increment(bucket_time)) {
+			window_no_result_requests_.fetch_add(1, std::memory_order_relaxed);
+		};
+		if (heavy_hitter_capacity_ > 0) {
+			CountNoResultQuery(query);
+		};
+	};
+}
+
+void RequestQueue::CountNoResultQuery(const std::string& query) {
+	std::lock_guard guard(heavy_hitters_mutex_);
+	if (const auto it = heavy_hitter_indexes_.find(query); it != heavy_hitter_indexes_.end()) {
+		++heavy_hitters_[it->second].count;
+		return;
+	};
+	if (heavy_hitters_.size() < heavy_hitter_capacity_) {
+		heavy_hitter_indexes_.emplace(query, heavy_hitters_.size());
+		heavy_hitters_.push_back({ query, 1, 0 });
+		return;
+	};
+	const auto least_frequent = std::min_element(heavy_hitters_.begin(), heavy_hitters_.end(),
+		[](const HeavyHitter& lhs, const HeavyHitter& rhs) { return lhs.count < rhs.count; });
+	heavy_hitter_indexes_.erase(least_frequent->query);
+	heavy_hitter_indexes_.emplace(query, static_cast<size_t>(least_frequent - heavy_hitters_.begin()));
+	least_frequent->query = query;
+	least_frequent->error = least_frequent->count;
+	++least_frequent->count;
+}
+
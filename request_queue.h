@@ -1,16 +1,33 @@
 #pragma once
 #include<vector>
 #include<string>
-#include<deque>
+#include<array>
+#include<atomic>
+#include<chrono>
+#include<cstdint>
+#include<functional>
+#include<mutex>
+#include<unordered_map>
 
 #include "document.h"
 #include "search_server.h"
 
-//this class can count how many empty results have been for search requests
-//working by passing reference to SearchServer object to constructor and then adding reqests with AddFindRequest method 
+//this class can count how many empty results have been for search requests during the last day
+//working by passing reference to SearchServer object to constructor and then adding reqests with AddFindRequest method.
+//Statistics is kept in fixed ring of per-minute counters and running totals of the window which are updated
+//with atomic operations, so requests can be added from many threads at once and memory does not depend on amount
+//of requests. When the window moves to the next bucket, its expired counts are subtracted from totals
 class RequestQueue {
 public:
-	explicit RequestQueue(SearchServer&);
+	using Clock = std::function<std::chrono::steady_clock::time_point()>;
+
+	//length of one bucket of statistics and amount of buckets in the window
+	static constexpr std::chrono::minutes BUCKET_DURATION{ 1 };
+	static constexpr size_t BUCKET_COUNT = 1440;
+
+	//clock gives time of requests and of reading statistics, the window is the last BUCKET_COUNT buckets.
+	//If heavy_hitter_capacity is not zero, queries with empty results are tracked by sketch of this size
+	explicit RequestQueue(const SearchServer&, Clock clock = std::chrono::steady_clock::now, size_t heavy_hitter_capacity = 0);
 
 	template <typename DocumentPredicate>
 	std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
@@ -23,16 +40,77 @@ public:
 
 	std::vector<Document> AddFindRequest(const std::string&);
 
+	//processing queries in parallel with ProcessQueries and counting all of them
+	std::vector<std::vector<Document>> AddFindRequests(const std::vector<std::string>&);
+
+	//amounts in the window, they are read from running totals. Only the first call after the window moved
+	//expires buckets left behind, each bucket is expired once per its turn of the ring, so reading is O(1) amortized
 	int GetNoResultRequests() const;
 
+	int GetRequestCount() const;
+
+	//share of requests with empty results in the window, 0 if there were no requests
+	double GetNoResultRate() const;
+
+	//query with empty results which was seen often, its count is never lower than the real one
+	//and is higher by not more than error
+	struct HeavyHitter {
+		std::string query;
+		uint64_t count = 0;
+		uint64_t error = 0;
+	};
+
+	//the most frequent queries with empty results since creation, found by Space-Saving sketch:
+	//every query seen more than total / heavy_hitter_capacity times is guaranteed to be there
+	std::vector<HeavyHitter> GetTopNoResultQueries(size_t count) const;
+
 private:
-	struct QueryResult {
-		std::string query_;
-		bool successful_search_;
+	//counter of requests of one bucket: upper bits keep tag of the bucket time and lower bits keep amount,
+	//so counter of the old time is replaced by counter of the new one with single compare-and-swap
+	class BucketCounter {
+	public:
+		//adding request of the bucket time, false if the counter was already started for another time,
+		//so the request is out of the window
+		bool Increment(uint64_t bucket_time);
+
+		//starting counting of the new bucket time, amount of the expired time is returned
+		uint64_t Start(uint64_t bucket_time);
+
+	private:
+		std::atomic<uint64_t> value_{ 0 };
+	};
+
+	struct Bucket {
+		BucketCounter requests;
+		BucketCounter no_result_requests;
 	};
-	std::deque<QueryResult> requests_;
-	const static int sec_in_day_ = 1440;
-	SearchServer& search_server_;
+
+	const SearchServer& search_server_;
+	Clock clock_;
+	mutable std::array<Bucket, BUCKET_COUNT> buckets_; //reading of statistics can move the window
+
+	//buckets of times before this one are started, changed under the mutex when the window moves
+	mutable std::atomic<uint64_t> next_bucket_time_{ 0 };
+	mutable std::mutex window_mutex_;
+	//totals of the window: counts of started buckets are added and counts of expired ones are subtracted,
+	//so they can be negative for a moment when request is counted in bucket which expires at the same time
+	mutable std::atomic<int64_t> window_requests_{ 0 };
+	mutable std::atomic<int64_t> window_no_result_requests_{ 0 };
+
+	//Space-Saving sketch: when it is full, new query replaces the query with the smallest count
+	//and inherits this count as its error
+	const size_t heavy_hitter_capacity_;
+	mutable std::mutex heavy_hitters_mutex_;
+	std::vector<HeavyHitter> heavy_hitters_;
+	std::unordered_map<std::string, size_t> heavy_hitter_indexes_; //query and its index in heavy_hitters_
+
+	uint64_t GetBucketTime() const;
+
+	//moving the window so that it ends with the bucket time: buckets between are started and
+	//their previous counts are subtracted from totals
+	void MoveWindow(uint64_t bucket_time) const;
 
 	void NewQuery(const std::string&, const std::vector<Document>&);
+
+	void CountNoResultQuery(const std::string&);
 };
@@ -0,0 +1,24 @@
+#include "score_accumulator.h"
+
+void ScoreAccumulator::Reset(size_t slot_count) {
+	for (const DocumentSlot slot : touched_) {
+		relevances_[slot] = 0.0;
+		touched_bits_[slot / 64] = 0;
+	};
+	for (const DocumentSlot slot : excluded_) {
+		excluded_bits_[slot / 64] = 0;
+	};
+	touched_.clear();
+	excluded_.clear();
+
+	if (relevances_.size() < slot_count) {
+		relevances_.resize(slot_count, 0.0);
+		touched_bits_.resize((slot_count + 63) / 64, 0);
+		excluded_bits_.resize((slot_count + 63) / 64, 0);
+	};
+}
+
+ScoreAccumulator& ScoreAccumulator::ForCurrentThread() {
+	thread_local ScoreAccumulator accumulator;
+	return accumulator;
+}
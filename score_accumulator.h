@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "document_table.h"
+
+//accumulator of documents relevances for one query, relevances are kept in flat array indexed by document slot.
+//Slots of documents with minus words are marked in bitmap. Only touched slots are cleared by Reset,
+//so one object is reused for many queries of one thread and there are no allocations while scoring
+class ScoreAccumulator {
+public:
+	//clearing results of the previous query and preparing arrays for slots less than slot_count
+	void Reset(size_t slot_count);
+
+	void Add(DocumentSlot slot, double relevance) {
+		if (!IsBitSet(touched_bits_, slot)) {
+			SetBit(touched_bits_, slot);
+			touched_.push_back(slot);
+		};
+		relevances_[slot] += relevance;
+	}
+
+	//marking document as containing minus word, it will be skipped by ForEach
+	void Exclude(DocumentSlot slot) {
+		if (!IsBitSet(excluded_bits_, slot)) {
+			SetBit(excluded_bits_, slot);
+			excluded_.push_back(slot);
+		};
+	}
+
+	bool IsExcluded(DocumentSlot slot) const {
+		return IsBitSet(excluded_bits_, slot);
+	}
+
+	//calling func(slot, relevance) for every touched and not excluded document
+	template <typename Function>
+	void ForEach(Function func) const {
+		for (const DocumentSlot slot : touched_) {
+			if (!IsExcluded(slot)) {
+				func(slot, relevances_[slot]);
+			};
+		};
+	}
+
+	//accumulator of the calling thread, it is reused by all queries of the thread
+	static ScoreAccumulator& ForCurrentThread();
+
+private:
+	std::vector<double> relevances_;
+	std::vector<uint64_t> touched_bits_;
+	std::vector<uint64_t> excluded_bits_;
+	std::vector<DocumentSlot> touched_;
+	std::vector<DocumentSlot> excluded_;
+
+	static bool IsBitSet(const std::vector<uint64_t>& bits, DocumentSlot slot) {
+		return (bits[slot / 64] >> (slot % 64)) & 1u;
+	}
+
+	static void SetBit(std::vector<uint64_t>& bits, DocumentSlot slot) {
+		bits[slot / 64] |= uint64_t{ 1 } << (slot % 64);
+	}
+};
@@ -0,0 +1,253 @@
+#include "search_metrics.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace std::string_view_literals;
+
+namespace {
+	//living metrics by slots, generation of slot is 0 while it is free
+	struct MetricsRegistry {
+		struct Slot {
+			uint64_t generation = 0;
+			SearchMetrics* metrics = nullptr;
+		};
+
+		std::mutex mutex;
+		std::vector<Slot> slots;
+		std::vector<size_t> free_slots;
+		uint64_t next_generation = 1;
+	};
+
+	MetricsRegistry& GetMetricsRegistry() {
+		static MetricsRegistry registry;
+		return registry;
+	}
+}
+
+struct SearchMetrics::ThreadShards {
+	struct Entry {
+		uint64_t generation = 0;
+		Shard* shard = nullptr;
+	};
+
+	std::vector<Entry> entries; //index is slot of metrics
+
+	//metrics can not be destroyed while the registry is locked, so shards are returned only to living metrics
+	~ThreadShards() {
+		MetricsRegistry& registry = GetMetricsRegistry();
+		std::lock_guard guard(registry.mutex);
+		for (size_t slot = 0; slot < entries.size(); ++slot) {
+			if (entries[slot].shard != nullptr && registry.slots[slot].generation == entries[slot].generation) {
+				registry.slots[slot].metrics->ReleaseShard(entries[slot].shard);
+			};
+		};
+	}
+};
+
+std::string_view GetSearchStageName(SearchStage stage) {
+	switch (stage) {
+	case SearchStage::QUERY:
+		return "query"sv;
+	case SearchStage::PARSE:
+		return "parse"sv;
+	case SearchStage::POSTING_SCAN:
+		return "posting_scan"sv;
+	case SearchStage::MINUS_FILTER:
+		return "minus_filter"sv;
+	case SearchStage::TOP_K:
+		return "top_k"sv;
+	case SearchStage::PREDICATE:
+		return "predicate"sv;
+	};
+	return {};
+}
+
+std::string_view GetSearchCounterName(SearchCounter counter) {
+	switch (counter) {
+	case SearchCounter::QUERIES:
+		return "queries"sv;
+	case SearchCounter::POSTINGS_SCANNED:
+		return "postings_scanned"sv;
+	case SearchCounter::CANDIDATES_SCORED:
+		return "candidates_scored"sv;
+	};
+	return {};
+}
+
+size_t LatencyHistogram::GetBucket(uint64_t nanoseconds) {
+	if (nanoseconds < SUB_BUCKET_COUNT) {
+		return static_cast<size_t>(nanoseconds);
+	};
+	//power is at least 2, next two bits after the highest one choose the sub-bucket
+	const size_t power = 63 - __builtin_clzll(nanoseconds);
+	const size_t sub_bucket = (nanoseconds >> (power - 2)) & (SUB_BUCKET_COUNT - 1);
+	return std::min(BUCKET_COUNT - 1, (power - 1) * SUB_BUCKET_COUNT + sub_bucket);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket) {
+	if (bucket < SUB_BUCKET_COUNT) {
+		return bucket;
+	};
+	const size_t power = bucket / SUB_BUCKET_COUNT + 1;
+	const uint64_t sub_bucket_size = uint64_t{1} << (power - 2);
+	return (SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT + 1) * sub_bucket_size - 1;
+}
+
+void LatencyHistogram::Add(size_t bucket, uint64_t count, uint64_t sum_nanoseconds) {
+	buckets_[bucket] += count;
+	count_ += count;
+	sum_nanoseconds_ += sum_nanoseconds;
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+	return count_;
+}
+
+uint64_t LatencyHistogram::GetSumNanoseconds() const {
+	return sum_nanoseconds_;
+}
+
+uint64_t LatencyHistogram::GetPercentileNanoseconds(double share) const {
+	if (count_ == 0) {
+		return 0;
+	};
+	//rank of the duration counting from 1, the bucket where cumulative count reaches it contains the duration
+	const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(share * count_ + 0.5));
+	uint64_t cumulative_count = 0;
+	for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+		cumulative_count += buckets_[bucket];
+		if (cumulative_count >= rank) {
+			return GetBucketUpperBound(bucket);
+		};
+	};
+	return GetBucketUpperBound(BUCKET_COUNT - 1);
+}
+
+void ExportSearchMetrics(std::ostream& output, const SearchMetricsSnapshot& snapshot) {
+	output << "# TYPE search_stage_seconds summary"s << std::endl;
+	for (size_t stage = 0; stage < SEARCH_STAGE_COUNT; ++stage) {
+		const LatencyHistogram& histogram = snapshot.stages[stage];
+		const std::string_view name = GetSearchStageName(static_cast<SearchStage>(stage));
+		for (const double quantile : { 0.5, 0.9, 0.99 }) {
+			output << "search_stage_seconds{stage=\""s << name << "\",quantile=\""s << quantile << "\"} "s
+				<< histogram.GetPercentileNanoseconds(quantile) * 1e-9 << std::endl;
+		};
+		output << "search_stage_seconds_sum{stage=\""s << name << "\"} "s << histogram.GetSumNanoseconds() * 1e-9 << std::endl;
+		output << "search_stage_seconds_count{stage=\""s << name << "\"} "s << histogram.GetCount() << std::endl;
+	};
+	for (size_t counter = 0; counter < SEARCH_COUNTER_COUNT; ++counter) {
+		const std::string_view name = GetSearchCounterName(static_cast<SearchCounter>(counter));
+		output << "# TYPE search_"s << name << "_total counter"s << std::endl;
+		output << "search_"s << name << "_total "s << snapshot.counters[counter] << std::endl;
+	};
+}
+
+SearchMetrics::SearchMetrics() {
+	MetricsRegistry& registry = GetMetricsRegistry();
+	std::lock_guard guard(registry.mutex);
+	if (registry.free_slots.empty()) {
+		slot_ = registry.slots.size();
+		registry.slots.emplace_back();
+	}
+	else {
+		slot_ = registry.free_slots.back();
+		registry.free_slots.pop_back();
+	};
+	generation_ = registry.next_generation++;
+	registry.slots[slot_] = { generation_, this };
+}
+
+SearchMetrics::~SearchMetrics() {
+	MetricsRegistry& registry = GetMetricsRegistry();
+	std::lock_guard guard(registry.mutex);
+	registry.slots[slot_] = {};
+	registry.free_slots.push_back(slot_);
+}
+
+void SearchMetrics::Record(SearchStage stage, std::chrono::steady_clock::duration duration) {
+	const uint64_t nanoseconds = static_cast<uint64_t>(std::max<int64_t>(0,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+	Shard& shard = GetThreadShard();
+	const size_t stage_index = static_cast<size_t>(stage);
+	shard.buckets[stage_index][LatencyHistogram::GetBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	shard.sums[stage_index].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void SearchMetrics::Count(SearchCounter counter, uint64_t value) {
+	GetThreadShard().counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+SearchMetricsSnapshot SearchMetrics::GetSnapshot() const {
+	SearchMetricsSnapshot snapshot;
+	std::lock_guard guard(shards_mutex_);
+	for (const auto& shard_ptr : shards_) {
+		const Shard& shard = *shard_ptr;
+		for (size_t stage = 0; stage < SEARCH_STAGE_COUNT; ++stage) {
+			for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+				const uint64_t count = shard.buckets[stage][bucket].load(std::memory_order_relaxed);
+				if (count > 0) {
+					snapshot.stages[stage].Add(bucket, count, 0);
+				};
+			};
+			snapshot.stages[stage].Add(0, 0, shard.sums[stage].load(std::memory_order_relaxed));
+		};
+		for (size_t counter = 0; counter < SEARCH_COUNTER_COUNT; ++counter) {
+			snapshot.counters[counter] += shard.counters[counter].load(std::memory_order_relaxed);
+		};
+	};
+	return snapshot;
+}
+
+void SearchMetrics::Reset() {
+	std::lock_guard guard(shards_mutex_);
+	for (const auto& shard_ptr : shards_) {
+		Shard& shard = *shard_ptr;
+		for (auto& stage_buckets : shard.buckets) {
+			for (auto& bucket : stage_buckets) {
+				bucket.store(0, std::memory_order_relaxed);
+			};
+		};
+		for (auto& sum : shard.sums) {
+			sum.store(0, std::memory_order_relaxed);
+		};
+		for (auto& counter : shard.counters) {
+			counter.store(0, std::memory_order_relaxed);
+		};
+	};
+}
+
+size_t SearchMetrics::GetShardCount() const {
+	std::lock_guard guard(shards_mutex_);
+	return shards_.size();
+}
+
+SearchMetrics::Shard& SearchMetrics::GetThreadShard() {
+	//entry of the slot can be left by destroyed metrics, then its generation differs
+	thread_local ThreadShards thread_shards;
+	if (slot_ < thread_shards.entries.size() && thread_shards.entries[slot_].generation == generation_) {
+		return *thread_shards.entries[slot_].shard;
+	};
+	if (slot_ >= thread_shards.entries.size()) {
+		thread_shards.entries.resize(slot_ + 1);
+	};
+	Shard* shard = nullptr;
+	{
+		std::lock_guard guard(shards_mutex_);
+		if (!free_shards_.empty()) {
+			shard = free_shards_.back();
+			free_shards_.pop_back();
+		}
+		else {
+			shards_.push_back(std::make_unique<Shard>());
+			shard = shards_.back().get();
+		};
+	}
+	thread_shards.entries[slot_] = { generation_, shard };
+	return *shard;
+}
+
+void SearchMetrics::ReleaseShard(Shard* shard) {
+	std::lock_guard guard(shards_mutex_);
+	free_shards_.push_back(shard);
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+//metrics of search are compiled in only if SEARCH_SERVER_ENABLE_METRICS is defined, they read clock several times
+//per search. Without them all hooks below are empty and SearchServer has no metrics at all
+#ifdef SEARCH_SERVER_ENABLE_METRICS
+#define SEARCH_SERVER_METRICS_ENABLED
+#endif
+
+//stages of search which durations are recorded, stages of parallel search are recorded by every part separately
+enum class SearchStage {
+	QUERY, //whole FindTopDocuments call
+	PARSE,
+	POSTING_SCAN,
+	MINUS_FILTER,
+	TOP_K, //pushing scored documents into heap and extracting the best of them
+	PREDICATE, //single call of document predicate, only every PREDICATE_SAMPLE_PERIOD-th call is measured
+};
+
+const size_t SEARCH_STAGE_COUNT = 6;
+
+enum class SearchCounter {
+	QUERIES,
+	POSTINGS_SCANNED,
+	CANDIDATES_SCORED, //documents which relevance is computed and offered to the heap
+};
+
+const size_t SEARCH_COUNTER_COUNT = 3;
+
+std::string_view GetSearchStageName(SearchStage);
+
+std::string_view GetSearchCounterName(SearchCounter);
+
+//log-linear histogram of durations in nanoseconds: durations below SUB_BUCKET_COUNT are exact, every next power of two
+//is split into SUB_BUCKET_COUNT equal buckets, so percentiles have relative error below 1 / SUB_BUCKET_COUNT
+class LatencyHistogram {
+public:
+	static const size_t SUB_BUCKET_COUNT = 4;
+
+	//durations longer than 2^36 ns (about a minute) go to the last bucket
+	static const size_t BUCKET_COUNT = 35 * SUB_BUCKET_COUNT;
+
+	static size_t GetBucket(uint64_t nanoseconds);
+
+	//the biggest duration of the bucket
+	static uint64_t GetBucketUpperBound(size_t bucket);
+
+	void Add(size_t bucket, uint64_t count, uint64_t sum_nanoseconds);
+
+	uint64_t GetCount() const;
+
+	uint64_t GetSumNanoseconds() const;
+
+	uint64_t GetBucketCount(size_t bucket) const {
+		return buckets_[bucket];
+	}
+
+	//upper bound of the bucket containing the given share of durations, 0 for empty histogram
+	uint64_t GetPercentileNanoseconds(double share) const;
+
+private:
+	std::array<uint64_t, BUCKET_COUNT> buckets_{};
+	uint64_t count_ = 0;
+	uint64_t sum_nanoseconds_ = 0;
+};
+
+struct SearchMetricsSnapshot {
+	std::array<LatencyHistogram, SEARCH_STAGE_COUNT> stages;
+	std::array<uint64_t, SEARCH_COUNTER_COUNT> counters{};
+
+	const LatencyHistogram& GetStage(SearchStage stage) const {
+		return stages[static_cast<size_t>(stage)];
+	}
+
+	uint64_t GetCounter(SearchCounter counter) const {
+		return counters[static_cast<size_t>(counter)];
+	}
+};
+
+//writing metrics in Prometheus text format: stages as summaries with quantiles and counters as counters
+void ExportSearchMetrics(std::ostream&, const SearchMetricsSnapshot&);
+
+//counters and histograms of search. Every thread gets its own shard on the first record and it is registered
+//in the metrics, values are relaxed atomics, so recording never locks and threads do not share cache lines.
+//When thread exits, its shards are returned to their metrics with their values and are given to new threads,
+//so amount of shards is not bigger than the biggest amount of threads recording at the same time.
+//Every thread keeps its shards in table indexed by slots of living metrics, slots of destroyed metrics are reused,
+//so the table is not bigger than the biggest amount of metrics living at the same time.
+//Snapshot sums all shards, it can miss records which are made at the same time
+class SearchMetrics {
+public:
+	SearchMetrics();
+
+	~SearchMetrics();
+
+	SearchMetrics(const SearchMetrics&) = delete;
+	SearchMetrics& operator=(const SearchMetrics&) = delete;
+
+	//only every PREDICATE_SAMPLE_PERIOD-th call of predicate in the thread is measured, reading clock on every
+	//posting would cost more than most predicates
+	static const uint32_t PREDICATE_SAMPLE_PERIOD = 64;
+
+	void Record(SearchStage, std::chrono::steady_clock::duration);
+
+	void Count(SearchCounter, uint64_t value);
+
+	SearchMetricsSnapshot GetSnapshot() const;
+
+	void Reset();
+
+	size_t GetShardCount() const;
+
+	//recording duration of the stage from construction to destruction
+	class StageTimer {
+	public:
+		StageTimer(SearchMetrics& metrics, SearchStage stage) : metrics_(metrics), stage_(stage) {}
+
+		StageTimer(const StageTimer&) = delete;
+		StageTimer& operator=(const StageTimer&) = delete;
+
+		~StageTimer() {
+			metrics_.Record(stage_, std::chrono::steady_clock::now() - start_time_);
+		}
+
+	private:
+		SearchMetrics& metrics_;
+		SearchStage stage_;
+		std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+	};
+
+	//predicate which measures part of its calls as PREDICATE stage
+	template <typename DocumentPredicate>
+	auto MeasurePredicate(DocumentPredicate document_predicate) {
+		return [this, document_predicate](int document_id, DocumentStatus status, int rating) -> bool {
+			thread_local uint32_t call_index = 0;
+			if (++call_index % PREDICATE_SAMPLE_PERIOD != 0) {
+				return document_predicate(document_id, status, rating);
+			};
+			StageTimer timer(*this, SearchStage::PREDICATE);
+			return document_predicate(document_id, status, rating);
+		};
+	}
+
+private:
+	struct alignas(64) Shard {
+		std::array<std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT>, SEARCH_STAGE_COUNT> buckets{};
+		std::array<std::atomic<uint64_t>, SEARCH_STAGE_COUNT> sums{};
+		std::array<std::atomic<uint64_t>, SEARCH_COUNTER_COUNT> counters{};
+	};
+
+	//shards of the thread, they are returned to their metrics when the thread exits
+	struct ThreadShards;
+
+	size_t slot_; //index among living metrics, it is reused after destruction
+	uint64_t generation_; //unique, so thread does not take shard of destroyed metrics which had the same slot
+	mutable std::mutex shards_mutex_; //locked only when thread records for the first time or exits, by snapshot and reset
+	std::vector<std::unique_ptr<Shard>> shards_;
+	std::vector<Shard*> free_shards_; //shards of exited threads
+
+	Shard& GetThreadShard();
+
+	void ReleaseShard(Shard*);
+};
+
+//value counted by one search call and added to metrics at once, so hot loops do not touch shared memory.
+//It is empty when metrics are disabled and increments are compiled out
+class LocalSearchCounter {
+public:
+	void operator++() {
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+		++value_;
+#endif
+	}
+
+	void operator+=([[maybe_unused]] uint64_t value) {
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+		value_ += value;
+#endif
+	}
+
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+	uint64_t Get() const {
+		return value_;
+	}
+
+private:
+	uint64_t value_ = 0;
+#endif
+};
+
+#define SEARCH_METRICS_CONCAT_INTERNAL(X, Y) X ## Y
+#define SEARCH_METRICS_CONCAT(X, Y) SEARCH_METRICS_CONCAT_INTERNAL(X, Y)
+
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+#define SEARCH_METRICS_STAGE(metrics, stage) SearchMetrics::StageTimer SEARCH_METRICS_CONCAT(search_stage_timer, __LINE__)(metrics, stage)
+#define SEARCH_METRICS_COUNT(metrics, counter, value) (metrics).Count(counter, value)
+#define SEARCH_METRICS_MEASURE_PREDICATE(metrics, predicate) (metrics).MeasurePredicate(predicate)
+#else
+#define SEARCH_METRICS_STAGE(metrics, stage)
+#define SEARCH_METRICS_COUNT(metrics, counter, value)
+#define SEARCH_METRICS_MEASURE_PREDICATE(metrics, predicate) (predicate)
+#endif
@@ -1,5 +1,7 @@
 #include "search_server.h"
 
+#include <cstring>
+
 SearchServer::SearchServer(const std::string& stop_words_text)
 	: SearchServer(SplitIntoWords(stop_words_text)) {}
 
@@ -7,23 +9,147 @@ SearchServer::SearchServer(const std::string_view& stop_words_view)
 	: SearchServer(SplitIntoWords(stop_words_view)) {}
 
 void SearchServer::AddDocument(int document_id, const std::string_view& document, DocumentStatus status, const std::vector<int>& ratings) {
-	if (document_id < 0 || documents_.count(document_id)) {
+	if (document_id < 0 || documents_.Contains(document_id)) {
 		//if recieved id is negative or already exists, throw exception
 		throw std::invalid_argument("Invalid document_id"s);
 	}
 	const auto words = SplitIntoWordsNoStop(document);
 
+	const DocumentSlot slot = documents_.Add(document_id, status, ComputeAverageRating(ratings));
+	++index_version_;
+
 	const double inv_word_count = 1.0 / words.size();
-	for (const std::string& word : words) {
-		word_to_document_freqs_[word][document_id] += inv_word_count;
-		document_words_freqs_[document_id][word] += inv_word_count;
+	auto& document_freqs = document_terms_freqs_.emplace_back();
+	for (const std::string_view word : words) {
+		document_freqs[terms_.AddTerm(word)] += inv_word_count;
+	}
+	//frequencies are fully counted, so every word gets exactly one posting
+	term_postings_.resize(terms_.size());
+	term_document_freqs_.resize(terms_.size());
+	term_log_document_freqs_.resize(terms_.size());
+	for (const auto& [term_id, term_freq] : document_freqs) {
+		term_postings_[term_id].Add(slot, term_freq);
+		++term_document_freqs_[term_id];
+		UpdateTermDocumentFreq(term_id);
+		SealFullTail(term_id);
 	}
-	documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-	document_ids_.insert(document_id);
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query, const DocumentStatus& status) const {
-	return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) { return document_status == status; });
+void SearchServer::AddDocuments(const std::vector<DocumentInput>& documents) {
+	//inverted index of one part of documents, postings are indexes of documents in the batch
+	struct PartIndex {
+		std::unordered_map<std::string_view, std::vector<std::pair<size_t, double>>> word_postings;
+		std::vector<std::vector<std::pair<std::string_view, double>>> document_word_freqs;
+		std::vector<std::string> errors; //error message for every invalid document of the part
+		std::vector<size_t> error_indexes;
+	};
+
+	const size_t part_count = std::clamp<size_t>(documents.size() / MIN_DOCUMENTS_PER_PART, 1, thread_pool_->GetWorkerCount() + 1);
+	const size_t part_size = (documents.size() + part_count - 1) / part_count;
+	std::vector<PartIndex> parts(part_count);
+
+	thread_pool_->ParallelFor(part_count, [&](size_t part) {
+		PartIndex& part_index = parts[part];
+		const size_t begin = std::min(documents.size(), part * part_size);
+		const size_t end = std::min(documents.size(), begin + part_size);
+		std::unordered_map<std::string_view, double> word_freqs;
+		for (size_t index = begin; index < end; ++index) {
+			std::vector<std::string_view> words;
+			try {
+				words = SplitIntoWordsNoStop(documents[index].text);
+			}
+			catch (const std::invalid_argument& e) {
+				part_index.errors.push_back(e.what());
+				part_index.error_indexes.push_back(index);
+				part_index.document_word_freqs.emplace_back();
+				continue;
+			};
+
+			//frequencies are counted the same way as in AddDocument to get exactly the same values
+			const double inv_word_count = 1.0 / words.size();
+			word_freqs.clear();
+			for (const std::string_view word : words) {
+				word_freqs[word] += inv_word_count;
+			};
+			auto& document_freqs = part_index.document_word_freqs.emplace_back(word_freqs.begin(), word_freqs.end());
+			for (const auto& [word, term_freq] : document_freqs) {
+				part_index.word_postings[word].push_back({ index, term_freq });
+			};
+		};
+		});
+
+	//checking all documents in order before changing anything
+	std::set<int> batch_ids;
+	std::vector<std::pair<size_t, std::string>> word_errors;
+	for (PartIndex& part_index : parts) {
+		for (size_t i = 0; i < part_index.errors.size(); ++i) {
+			word_errors.push_back({ part_index.error_indexes[i], std::move(part_index.errors[i]) });
+		};
+	};
+	auto word_error_iter = word_errors.begin();
+	for (size_t index = 0; index < documents.size(); ++index) {
+		const int document_id = documents[index].id;
+		if (document_id < 0 || documents_.Contains(document_id) || !batch_ids.insert(document_id).second) {
+			//if recieved id is negative or already exists, throw exception
+			throw std::invalid_argument("Invalid document_id"s);
+		};
+		if (word_error_iter != word_errors.end() && word_error_iter->first == index) {
+			throw std::invalid_argument(word_error_iter->second);
+		};
+	};
+
+	//documents get slots in order of the batch, so postings of every part are appended to the end of lists
+	const DocumentSlot first_slot = static_cast<DocumentSlot>(documents_.GetSlotCount());
+	for (const DocumentInput& document : documents) {
+		documents_.Add(document.id, document.status, ComputeAverageRating(document.ratings));
+	};
+	++index_version_;
+	for (const PartIndex& part_index : parts) {
+		for (const auto& [word, postings] : part_index.word_postings) {
+			const TermId term_id = terms_.AddTerm(word);
+			if (term_id >= term_postings_.size()) {
+				term_postings_.resize(terms_.size());
+				term_document_freqs_.resize(terms_.size());
+				term_log_document_freqs_.resize(terms_.size());
+			};
+			for (const auto& [index, term_freq] : postings) {
+				term_postings_[term_id].Add(static_cast<DocumentSlot>(first_slot + index), term_freq);
+			};
+			term_document_freqs_[term_id] += static_cast<uint32_t>(postings.size());
+			UpdateTermDocumentFreq(term_id);
+			SealFullTail(term_id);
+		};
+	};
+
+	//all words are in the dictionary now, so forward index can be filled in parallel
+	document_terms_freqs_.resize(documents_.GetSlotCount());
+	thread_pool_->ParallelFor(part_count, [&](size_t part) {
+		const size_t begin = std::min(documents.size(), part * part_size);
+		for (size_t i = 0; i < parts[part].document_word_freqs.size(); ++i) {
+			auto& document_freqs = document_terms_freqs_[first_slot + begin + i];
+			for (const auto& [word, term_freq] : parts[part].document_word_freqs[i]) {
+				document_freqs.emplace(terms_.FindTerm(word), term_freq);
+			};
+		};
+		});
+}
+
+void SearchServer::SetThreadPool(std::shared_ptr<ThreadPool> thread_pool) {
+	thread_pool_ = std::move(thread_pool);
+}
+
+ThreadPool& SearchServer::GetThreadPool() const {
+	return *thread_pool_;
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query, const DocumentStatus& status,
+	size_t max_result_count) const {
+	return FindTopDocuments(raw_query, DocumentFilter(status), max_result_count);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query, const DocumentFilter& filter,
+	size_t max_result_count) const {
+	return FindTopDocumentsWithCache(std::execution::seq, raw_query, filter, max_result_count, filter.GetCacheKey());
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query) const {
@@ -31,22 +157,48 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw
 }
 
 int SearchServer::GetDocumentCount() const {
-	return static_cast<int>(document_ids_.size());
+	return static_cast<int>(documents_.size());
+}
+
+uint64_t SearchServer::GetIndexVersion() const {
+	return index_version_;
+}
+
+void SearchServer::SetQueryCacheCapacity(size_t capacity) {
+	query_cache_.SetCapacity(capacity);
+}
+
+QueryCacheStats SearchServer::GetQueryCacheStats() const {
+	return query_cache_.GetStats();
+}
+
+SearchMetricsSnapshot SearchServer::GetMetrics() const {
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+	return metrics_->GetSnapshot();
+#else
+	return {};
+#endif
+}
+
+void SearchServer::ResetMetrics() {
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+	metrics_->Reset();
+#endif
 }
 
 int SearchServer::GetDocumentId(int id) const {
-	const auto id_iter = document_ids_.find(id);
-	if (id_iter == document_ids_.end()) { //if requested id doesnt exist, throw exception
+	if (!documents_.Contains(id)) { //if requested id doesnt exist, throw exception
 		throw std::out_of_range("Invalid document id!"s);
 	};
-	return *(id_iter);
+	return id;
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
 	const std::string_view& raw_query, int document_id) const {
 
 	//throw exception if document with recieved id does not exist
-	if (document_ids_.count(document_id) == 0) {
+	const DocumentSlot slot = documents_.FindSlot(document_id);
+	if (slot == NO_SLOT) {
 		throw std::out_of_range("Invalid id"s);
 	};
 
@@ -54,42 +206,91 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 
 	std::vector<std::string_view> matched_words;
 	//find and add all matched words to result vector
-	for (const std::string& word : temp_query.plus_words) {
-		if (word_to_document_freqs_.count(word) &&
-			word_to_document_freqs_.at(word).count(document_id)) {
-			matched_words.push_back(std::string_view((*word_to_document_freqs_.find(word)).first));
+	for (const std::string_view word : temp_query.plus_words) {
+		const TermId term_id = terms_.FindTerm(word);
+		if (IsTermInDocument(term_id, slot)) {
+			matched_words.push_back(terms_.GetTerm(term_id));
 		}
 	}
 
 	//if any of minus words exists in the document we are looking for matches, then clear all matched words
-	for (const std::string& word : temp_query.minus_words) {
-		if (word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id)) {
+	for (const std::string_view word : temp_query.minus_words) {
+		if (IsTermInDocument(terms_.FindTerm(word), slot)) {
 			matched_words.clear();
 			break;
 		}
 	}
-	return { matched_words, documents_.at(document_id).status };
+	return { matched_words, documents_.GetStatus(slot) };
 }
 
-bool SearchServer::IsStopWord(const std::string& word) const {
-	return stop_words_.count(word);
-}
+void SearchServer::MatchDocuments(const std::string_view& raw_query, const std::vector<int>& document_ids,
+	std::vector<DocumentMatch>& matches) const {
+	std::vector<DocumentSlot> slots(document_ids.size());
+	for (size_t i = 0; i < document_ids.size(); ++i) {
+		slots[i] = documents_.FindSlot(document_ids[i]);
+		if (slots[i] == NO_SLOT) {
+			throw std::out_of_range("Invalid id"s);
+		};
+	};
+
+	//words which are not indexed can not be in any document, plus terms keep order of words as in MatchDocument
+	const auto query = ParseQuery(raw_query);
+	std::vector<TermId> plus_terms;
+	std::vector<TermId> minus_terms;
+	for (const std::string_view word : query.plus_words) {
+		if (const TermId term_id = terms_.FindTerm(word); term_id != NO_TERM) {
+			plus_terms.push_back(term_id);
+		};
+	};
+	for (const std::string_view word : query.minus_words) {
+		if (const TermId term_id = terms_.FindTerm(word); term_id != NO_TERM) {
+			minus_terms.push_back(term_id);
+		};
+	};
 
-bool SearchServer::IsValidWord(const std::string& word) {
-	// A valid word must not contain special characters
-	return none_of(word.begin(), word.end(), [](char c) {
-		return c >= '\0' && c < ' ';
+	matches.resize(document_ids.size());
+	const size_t part_count = std::min<size_t>(document_ids.size(), thread_pool_->GetWorkerCount() + 1);
+	const size_t part_size = part_count == 0 ? 0 : (document_ids.size() + part_count - 1) / part_count;
+	thread_pool_->ParallelFor(part_count, [&](size_t part) {
+		const size_t begin = std::min(document_ids.size(), part * part_size);
+		const size_t end = std::min(document_ids.size(), begin + part_size);
+		for (size_t i = begin; i < end; ++i) {
+			const DocumentSlot slot = slots[i];
+			DocumentMatch& match = matches[i];
+			match.id = document_ids[i];
+			match.status = documents_.GetStatus(slot);
+			match.words.clear();
+			const bool has_minus_word = std::any_of(minus_terms.begin(), minus_terms.end(),
+				[this, slot](TermId term_id) { return IsTermInDocument(term_id, slot); });
+			if (has_minus_word) {
+				continue;
+			};
+			for (const TermId term_id : plus_terms) {
+				if (IsTermInDocument(term_id, slot)) {
+					match.words.push_back(terms_.GetTerm(term_id));
+				};
+			};
+		};
 		});
 }
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string_view& text) const {
-	std::vector<std::string> words;
-	for (const std::string& word : SplitIntoWords(text)) {
-		if (!IsValidWord(word)) { //word should be valid
-			throw std::invalid_argument("Word "s + word + " is invalid"s);
+void SearchServer::MatchDocuments(const std::string_view& raw_query, std::vector<DocumentMatch>& matches) const {
+	MatchDocuments(raw_query, std::vector<int>(begin(), end()), matches);
+}
+
+bool SearchServer::IsStopWord(std::string_view word) const {
+	return stop_words_.count(word);
+}
+
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view& text) const {
+	std::vector<std::string_view> words;
+	const WordsRange words_range(text);
+	for (auto iter = words_range.begin(); iter != words_range.end(); ++iter) {
+		if (iter.HasSpecialChars()) { //word should be valid, it is checked while searching for its end
+			throw std::invalid_argument("Word "s + std::string(*iter) + " is invalid"s);
 		}
-		if (!IsStopWord(word)) { //word should not be a stop word
-			words.push_back(word);
+		if (!IsStopWord(*iter)) { //word should not be a stop word
+			words.push_back(*iter);
 		}
 	}
 	return words;
@@ -107,68 +308,425 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
 	return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string& text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text, bool has_special_chars) const {
 	if (text.empty()) { //query word should not be an empty word
 		throw std::invalid_argument("Query word is empty"s);
 	};
 
-	std::string word = text;
+	std::string_view word = text;
 	bool is_minus = false;
 	if (word[0] == '-') { //if word has minus character is front, it is a minus word
 		is_minus = true;
-		word = word.substr(1);
+		word.remove_prefix(1);
 	};
 
 	//if second character is minus too or there is no characters or word is not valid, then throw exception
-	if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-		throw std::invalid_argument("Query word "s + text + " is invalid"s);
+	if (word.empty() || word[0] == '-' || has_special_chars) {
+		throw std::invalid_argument("Query word "s + std::string(text) + " is invalid"s);
 	}
 
 	return { word, is_minus, IsStopWord(word) };
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const {
+	SEARCH_METRICS_STAGE(*metrics_, SearchStage::PARSE);
 	Query result;
-	for (const std::string& word : SplitIntoWords(text)) {
-		const auto query_word = ParseQueryWord(word);
+	const WordsRange words_range(text);
+	for (auto iter = words_range.begin(); iter != words_range.end(); ++iter) {
+		const auto query_word = ParseQueryWord(*iter, iter.HasSpecialChars());
 		if (!query_word.is_stop) { //word should not be a stop word
 			query_word.is_minus ?
-				result.minus_words.insert(query_word.data) : result.plus_words.insert(query_word.data);
+				result.minus_words.push_back(query_word.data) : result.plus_words.push_back(query_word.data);
 		}
 	}
+	//sorting and removing duplicates
+	for (auto* words : { &result.plus_words, &result.minus_words }) {
+		std::sort(words->begin(), words->end());
+		words->erase(std::unique(words->begin(), words->end()), words->end());
+	}
 	return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const {
-	return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeTermInverseDocumentFreq(TermId term_id, double log_document_count) const {
+	return log_document_count - term_log_document_freqs_[term_id];
+}
+
+void SearchServer::UpdateTermDocumentFreq(TermId term_id) {
+	const size_t document_freq = term_document_freqs_[term_id];
+	term_log_document_freqs_[term_id] = document_freq == 0 ? 0.0 : log(static_cast<double>(document_freq));
+}
+
+PostingList::RemovedSlots SearchServer::GetRemovedSlots() const {
+	return [this](DocumentSlot slot) { return documents_.IsRemoved(slot); };
+}
+
+void SearchServer::SealFullTail(TermId term_id) {
+	PostingList& postings = term_postings_[term_id];
+	if (postings.IsTailFull()) {
+		postings.SealTail(GetRemovedSlots());
+	};
+}
+
+std::string SearchServer::GetQueryCacheKey(const Query& query, const std::string& predicate_key, size_t max_result_count) const {
+	//words have no spaces, so they are separated by spaces, minus words are marked with minus
+	std::string key;
+	for (const std::string_view word : query.plus_words) {
+		key.append(word).push_back(' ');
+	};
+	for (const std::string_view word : query.minus_words) {
+		key.append("-"sv).append(word).push_back(' ');
+	};
+	return key + "| "s + predicate_key + " | "s + std::to_string(max_result_count);
+}
+
+SearchServer::QueryTerms SearchServer::ResolveQuery(const Query& query) const {
+	QueryTerms result;
+	const double log_document_count = log(static_cast<double>(GetDocumentCount()));
+	for (const std::string_view word : query.plus_words) {
+		const TermId term_id = terms_.FindTerm(word);
+		if (term_id != NO_TERM) {
+			result.plus_terms.push_back({ term_id, ComputeTermInverseDocumentFreq(term_id, log_document_count) });
+		};
+	};
+	for (const std::string_view word : query.minus_words) {
+		const TermId term_id = terms_.FindTerm(word);
+		if (term_id != NO_TERM) {
+			result.minus_terms.push_back(term_id);
+		};
+	};
+	return result;
+}
+
+bool SearchServer::IsTermInDocument(TermId term_id, DocumentSlot slot) const {
+	//forward index of the document is much shorter than posting list of the word
+	if (term_id == NO_TERM) {
+		return false;
+	};
+	if (slot < mapped_forward_.slot_count) {
+		return std::binary_search(mapped_forward_.term_ids + mapped_forward_.offsets[slot],
+			mapped_forward_.term_ids + mapped_forward_.offsets[slot + 1], term_id);
+	};
+	return document_terms_freqs_[slot].count(term_id);
 }
 
 const std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
 	std::map<std::string_view, double> result;
 
-	auto found_doc = document_words_freqs_.find(document_id);
-	if (found_doc != document_words_freqs_.end()) { //if document with requested id had been found
-		auto& temp_map = found_doc->second;
-		for (const auto& [word, freq] : temp_map) {
-			result.insert({ std::string_view(word), freq });
-		};
+	const DocumentSlot slot = documents_.FindSlot(document_id);
+	if (slot != NO_SLOT) { //if document with requested id had been found
+		ForEachDocumentTerm(slot, [this, &result](TermId term_id, double freq) {
+			result.insert({ terms_.GetTerm(term_id), freq });
+			});
 	};
 
 	return result;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
-	if (document_ids_.count(document_id)) { //if there is no document with recieved id, then do nothing
-		document_ids_.erase(document_ids_.find(document_id));
-		documents_.erase(documents_.find(document_id));
+	const DocumentSlot slot = documents_.FindSlot(document_id);
+	if (slot != NO_SLOT) { //if there is no document with recieved id, then do nothing
+		documents_.Remove(document_id);
+		++index_version_;
+
+		//postings of the document stay in posting lists until they are merged, tombstone of its slot hides them
+		ForEachDocumentTerm(slot, [this](TermId term_id, double) {
+			--term_document_freqs_[term_id];
+			UpdateTermDocumentFreq(term_id);
+			});
+
+		RemoveUnusedTerms(slot);
+		document_terms_freqs_[slot].clear();
+	};
+}
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+	std::vector<DocumentSlot> slots;
+	slots.reserve(document_ids.size());
+	for (const int document_id : document_ids) {
+		const DocumentSlot slot = documents_.FindSlot(document_id);
+		if (slot != NO_SLOT) {
+			documents_.Remove(document_id);
+			slots.push_back(slot);
+		};
+	};
+	if (slots.empty()) {
+		return;
+	};
+	++index_version_;
+
+	std::vector<TermId> changed_terms;
+	for (const DocumentSlot slot : slots) {
+		ForEachDocumentTerm(slot, [this, &changed_terms](TermId term_id, double) {
+			--term_document_freqs_[term_id];
+			changed_terms.push_back(term_id);
+			});
+	};
+	std::sort(changed_terms.begin(), changed_terms.end());
+	changed_terms.erase(std::unique(changed_terms.begin(), changed_terms.end()), changed_terms.end());
+
+	//words are removed here and not by RemoveUnusedTerms, the same word of several documents must be removed once
+	for (const TermId term_id : changed_terms) {
+		UpdateTermDocumentFreq(term_id);
+		if (term_document_freqs_[term_id] == 0) {
+			terms_.RemoveTerm(term_id);
+			term_postings_[term_id] = PostingList();
+		};
+	};
+	for (const DocumentSlot slot : slots) {
+		document_terms_freqs_[slot].clear();
+	};
+}
+
+void SearchServer::CompactTermStorage() {
+	terms_.Compact();
+}
+
+size_t SearchServer::GetUnusedTermBytes() const {
+	return terms_.GetUnusedBytes();
+}
+
+void SearchServer::RemoveUnusedTerms(DocumentSlot slot) {
+	ForEachDocumentTerm(slot, [this](TermId term_id, double) {
+		if (term_document_freqs_[term_id] == 0) {
+			terms_.RemoveTerm(term_id); //id of the word will be given to some new word
+			term_postings_[term_id] = PostingList();
+		};
+		});
+}
+
+void SearchServer::CompressPostings() {
+	//lists are compressed independently, every thread takes its own range of words
+	const size_t part_count = std::min<size_t>(term_postings_.size(), thread_pool_->GetWorkerCount() + 1);
+	thread_pool_->ParallelFor(part_count, [this, part_count](size_t part) {
+		for (size_t term_id = part; term_id < term_postings_.size(); term_id += part_count) {
+			term_postings_[term_id].Compress(GetRemovedSlots());
+		};
+		});
+}
+
+void SearchServer::MergeSegments() {
+	const size_t part_count = std::min<size_t>(term_postings_.size(), thread_pool_->GetWorkerCount() + 1);
+	thread_pool_->ParallelFor(part_count, [this, part_count](size_t part) {
+		for (size_t term_id = part; term_id < term_postings_.size(); term_id += part_count) {
+			term_postings_[term_id].Merge(GetRemovedSlots());
+		};
+		});
+}
+
+size_t SearchServer::GetPostingBytes() const {
+	size_t bytes = term_postings_.capacity() * sizeof(PostingList);
+	for (const PostingList& postings : term_postings_) {
+		bytes += postings.GetMemoryUsage();
+	};
+	return bytes;
+}
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+	SnapshotHeader header = {};
+	std::copy(std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC), header.magic);
+	header.version = SNAPSHOT_VERSION;
+	header.byte_order = SNAPSHOT_BYTE_ORDER;
 
-		for (const auto& [word, _] : document_words_freqs_.find(document_id)->second) {
-			auto& id_freq_map = word_to_document_freqs_.find(word)->second;
-			id_freq_map.erase(id_freq_map.find(document_id));
+	std::string stop_words;
+	for (const std::string& word : stop_words_) {
+		stop_words += stop_words.empty() ? word : " "s + word;
+	};
+	header.stop_words_size = stop_words.size();
+
+	//offsets of every word and its postings, removed words have empty bytes and no postings
+	std::vector<uint64_t> term_offsets(1, 0);
+	std::vector<uint64_t> posting_offsets(1, 0);
+	for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+		term_offsets.push_back(term_offsets.back() + terms_.GetTerm(term_id).size());
+		posting_offsets.push_back(posting_offsets.back() + term_document_freqs_[term_id]);
+	};
+	header.term_count = terms_.size();
+	header.term_bytes_size = term_offsets.back();
+	header.posting_count = posting_offsets.back();
+
+	//forward index is saved only for live documents, removed ones get empty ranges
+	std::vector<DocumentSlot> live_slots;
+	std::vector<bool> is_live(documents_.GetSlotCount(), false);
+	for (const int document_id : documents_) {
+		live_slots.push_back(documents_.FindSlot(document_id));
+		is_live[live_slots.back()] = true;
+	};
+	std::vector<uint64_t> forward_offsets(1, 0);
+	for (DocumentSlot slot = 0; slot < documents_.GetSlotCount(); ++slot) {
+		size_t term_count = 0;
+		if (is_live[slot]) {
+			ForEachDocumentTerm(slot, [&term_count](TermId, double) { ++term_count; });
+		};
+		forward_offsets.push_back(forward_offsets.back() + term_count);
+	};
+	header.slot_count = documents_.GetSlotCount();
+	header.document_count = live_slots.size();
+	header.forward_count = forward_offsets.back();
+
+	const SnapshotLayout layout(header);
+	SnapshotWriter writer(path);
+	writer.WriteValue(header);
+	writer.PadTo(layout.stop_words);
+	writer.Write(stop_words.data(), stop_words.size());
+	writer.PadTo(layout.term_offsets);
+	writer.WriteArray(term_offsets);
+	writer.PadTo(layout.term_bytes);
+	for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+		writer.Write(terms_.GetTerm(term_id).data(), terms_.GetTerm(term_id).size());
+	};
+	writer.PadTo(layout.posting_offsets);
+	writer.WriteArray(posting_offsets);
+	//postings of removed documents which are not merged yet are not saved
+	writer.PadTo(layout.posting_slots);
+	for (const PostingList& postings : term_postings_) {
+		postings.ForEach([this, &writer](DocumentSlot slot, double) {
+			if (!documents_.IsRemoved(slot)) {
+				writer.WriteValue(slot);
+			};
+			});
+	};
+	writer.PadTo(layout.posting_term_freqs);
+	for (const PostingList& postings : term_postings_) {
+		postings.ForEach([this, &writer](DocumentSlot slot, double term_freq) {
+			if (!documents_.IsRemoved(slot)) {
+				writer.WriteValue(term_freq);
+			};
+			});
+	};
+	writer.PadTo(layout.document_ids);
+	for (DocumentSlot slot = 0; slot < documents_.GetSlotCount(); ++slot) {
+		writer.WriteValue(static_cast<int32_t>(documents_.GetId(slot)));
+	};
+	writer.PadTo(layout.document_statuses);
+	for (DocumentSlot slot = 0; slot < documents_.GetSlotCount(); ++slot) {
+		writer.WriteValue(static_cast<int32_t>(documents_.GetStatus(slot)));
+	};
+	writer.PadTo(layout.document_ratings);
+	for (DocumentSlot slot = 0; slot < documents_.GetSlotCount(); ++slot) {
+		writer.WriteValue(static_cast<int32_t>(documents_.GetRating(slot)));
+	};
+	writer.PadTo(layout.live_slots);
+	writer.WriteArray(live_slots);
+	writer.PadTo(layout.forward_offsets);
+	writer.WriteArray(forward_offsets);
+	writer.PadTo(layout.forward_term_ids);
+	for (DocumentSlot slot = 0; slot < documents_.GetSlotCount(); ++slot) {
+		if (is_live[slot]) {
+			ForEachDocumentTerm(slot, [&writer](TermId term_id, double) { writer.WriteValue(term_id); });
 		};
+	};
+	writer.PadTo(layout.forward_term_freqs);
+	for (DocumentSlot slot = 0; slot < documents_.GetSlotCount(); ++slot) {
+		if (is_live[slot]) {
+			ForEachDocumentTerm(slot, [&writer](TermId, double term_freq) { writer.WriteValue(term_freq); });
+		};
+	};
+	writer.Finish();
+}
 
-		document_words_freqs_.erase(document_words_freqs_.find(document_id));
+SearchServer SearchServer::OpenSnapshot(const std::string& path) {
+	auto snapshot = std::make_shared<const MappedFile>(path);
+	SnapshotHeader header;
+	if (snapshot->size() < sizeof(header)) {
+		throw std::runtime_error("File "s + path + " is not a search server snapshot"s);
+	};
+	std::memcpy(&header, snapshot->data(), sizeof(header));
+	if (!std::equal(std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC), header.magic)) {
+		throw std::runtime_error("File "s + path + " is not a search server snapshot"s);
 	};
+	if (header.version != SNAPSHOT_VERSION || header.byte_order != SNAPSHOT_BYTE_ORDER) {
+		throw std::runtime_error("Snapshot "s + path + " has unsupported version or byte order"s);
+	};
+	const SnapshotLayout layout(header);
+	if (layout.file_size != snapshot->size()) {
+		throw std::runtime_error("Snapshot "s + path + " is damaged"s);
+	};
+
+	const char* data = snapshot->data();
+	const auto* term_offsets = reinterpret_cast<const uint64_t*>(data + layout.term_offsets);
+	const auto* posting_offsets = reinterpret_cast<const uint64_t*>(data + layout.posting_offsets);
+	const auto* forward_offsets = reinterpret_cast<const uint64_t*>(data + layout.forward_offsets);
+	//offsets and all values used as indexes are checked once here, so damaged file can not make searches
+	//read out of arrays. Words and frequencies are used as they were written by SaveSnapshot
+	const auto is_valid_offsets = [](const uint64_t* offsets, uint64_t count, uint64_t total_size) {
+		return offsets[0] == 0 && offsets[count] == total_size && std::is_sorted(offsets, offsets + count + 1);
+	};
+	if (header.term_count >= NO_TERM || header.slot_count >= NO_SLOT || header.document_count > header.slot_count
+		|| !is_valid_offsets(term_offsets, header.term_count, header.term_bytes_size)
+		|| !is_valid_offsets(posting_offsets, header.term_count, header.posting_count)
+		|| !is_valid_offsets(forward_offsets, header.slot_count, header.forward_count)) {
+		throw std::runtime_error("Snapshot "s + path + " is damaged"s);
+	};
+	//values of every range [offsets[i], offsets[i + 1]) must increase and be less than limit
+	const auto is_valid_ranges = [](const uint64_t* offsets, uint64_t count, const uint32_t* values, uint64_t limit) {
+		for (uint64_t i = 0; i < count; ++i) {
+			for (uint64_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+				if (values[j] >= limit || (j > offsets[i] && values[j] <= values[j - 1])) {
+					return false;
+				};
+			};
+		};
+		return true;
+	};
+	const auto* posting_slots = reinterpret_cast<const DocumentSlot*>(data + layout.posting_slots);
+	const auto* forward_term_ids = reinterpret_cast<const TermId*>(data + layout.forward_term_ids);
+	const auto* ids = reinterpret_cast<const int32_t*>(data + layout.document_ids);
+	const auto* statuses = reinterpret_cast<const int32_t*>(data + layout.document_statuses);
+	const auto* live_slots = reinterpret_cast<const DocumentSlot*>(data + layout.live_slots);
+	//live documents are saved in increasing order of ids, so their ids are different
+	const auto is_valid_live_slots = [&]() {
+		for (uint64_t i = 0; i < header.document_count; ++i) {
+			if (live_slots[i] >= header.slot_count || ids[live_slots[i]] < 0
+				|| (i > 0 && ids[live_slots[i]] <= ids[live_slots[i - 1]])) {
+				return false;
+			};
+		};
+		return true;
+	};
+	if (!is_valid_ranges(posting_offsets, header.term_count, posting_slots, header.slot_count)
+		|| !is_valid_ranges(forward_offsets, header.slot_count, forward_term_ids, header.term_count)
+		|| !std::all_of(statuses, statuses + header.slot_count,
+			[](int32_t status) { return status >= 0 && static_cast<size_t>(status) < DOCUMENT_STATUS_COUNT; })
+		|| !is_valid_live_slots()) {
+		throw std::runtime_error("Snapshot "s + path + " is damaged"s);
+	};
+
+	SearchServer server(std::string_view(data + layout.stop_words, header.stop_words_size));
+
+	std::vector<std::string_view> terms(header.term_count);
+	for (size_t term_id = 0; term_id < terms.size(); ++term_id) {
+		terms[term_id] = std::string_view(data + layout.term_bytes + term_offsets[term_id],
+			term_offsets[term_id + 1] - term_offsets[term_id]);
+	};
+	server.terms_ = TermDictionary(terms);
+
+	const auto* posting_term_freqs = reinterpret_cast<const double*>(data + layout.posting_term_freqs);
+	server.term_postings_.reserve(header.term_count);
+	for (size_t term_id = 0; term_id < header.term_count; ++term_id) {
+		server.term_postings_.emplace_back(posting_slots + posting_offsets[term_id], posting_term_freqs + posting_offsets[term_id],
+			posting_offsets[term_id + 1] - posting_offsets[term_id]);
+	};
+	server.term_document_freqs_.resize(header.term_count);
+	server.term_log_document_freqs_.resize(header.term_count);
+	for (TermId term_id = 0; term_id < header.term_count; ++term_id) {
+		server.term_document_freqs_[term_id] = static_cast<uint32_t>(posting_offsets[term_id + 1] - posting_offsets[term_id]);
+		server.UpdateTermDocumentFreq(term_id);
+	};
+
+	//documents data is small, so it is copied into the table which can be changed later
+	const auto* ratings = reinterpret_cast<const int32_t*>(data + layout.document_ratings);
+	std::vector<DocumentStatus> document_statuses(header.slot_count);
+	std::transform(statuses, statuses + header.slot_count, document_statuses.begin(),
+		[](int32_t status) { return static_cast<DocumentStatus>(status); });
+	server.documents_ = DocumentTable(std::vector<int>(ids, ids + header.slot_count), std::move(document_statuses),
+		std::vector<int>(ratings, ratings + header.slot_count),
+		std::vector<DocumentSlot>(live_slots, live_slots + header.document_count));
+
+	server.document_terms_freqs_.resize(header.slot_count);
+	server.mapped_forward_ = { forward_offsets, forward_term_ids,
+		reinterpret_cast<const double*>(data + layout.forward_term_freqs), header.slot_count };
+	server.snapshot_ = std::move(snapshot);
+	return server;
 }
 
 //helps print MatchDocument method result 
@@ -213,9 +771,10 @@ void MatchDocuments(const SearchServer& search_server, const std::string& query)
 	LOG_DURATION_STREAM("Operation time"s, std::cout); //start counting duration
 	try {
 		std::cout << "Matched documents for: "s << query << std::endl;
-		for (const int id : search_server) {
-			const auto& [words, status] = search_server.MatchDocument(query, id);
-			PrintMatchDocumentResult(id, words, status);
+		std::vector<DocumentMatch> matches;
+		search_server.MatchDocuments(query, matches);
+		for (const DocumentMatch& match : matches) {
+			PrintMatchDocumentResult(match.id, match.words, match.status);
 		};
 	}
 	catch (const std::exception& e) {
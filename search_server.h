@@ -11,19 +11,33 @@
 #include <type_traits>
 #include <string_view>
 #include <tuple>
-#include <future>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <typeinfo>
+#include <optional>
+#include <cstdint>
 
 #include "string_processing.h"
 #include "document.h"
 #include "log_duration.h"
-#include "concurrent_map.h"
+#include "term_dictionary.h"
+#include "posting_list.h"
+#include "document_table.h"
+#include "document_filter.h"
+#include "search_traits.h"
+#include "top_documents.h"
+#include "score_accumulator.h"
+#include "thread_pool.h"
+#include "index_snapshot.h"
+#include "query_cache.h"
+#include "search_metrics.h"
 
 using namespace std::string_literals;
 using namespace std::string_view_literals;
 
+//default amount of documents returned by FindTopDocuments
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
-const double MAX_DIFF = 1e-6;
 
 class SearchServer {
 public:
@@ -44,77 +58,77 @@ public:
 
 	void AddDocument(int, const std::string_view&, DocumentStatus, const std::vector<int>&);
 
-	template <typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate) const {
-		const auto query = ParseQuery(raw_query);
+	//adding many documents at once: texts are split into words in parallel, every thread builds
+	//inverted index of its part of documents and then these indexes are merged into the server.
+	//Exceptions are the same as AddDocument throws for the first invalid document,
+	//if any document is invalid, no documents are added
+	void AddDocuments(const std::vector<DocumentInput>&);
 
-		//getting all matched documents using custom or dafault predicate
-		auto matched_documents = FindAllDocuments(query, document_predicate);
+	//pool used by parallel methods, by default it is ThreadPool::GetDefault() shared by all servers
+	void SetThreadPool(std::shared_ptr<ThreadPool>);
 
-		//first sorting by relevance and if relevances are almost the same, then sort by rating
-		sort(std::execution::seq, matched_documents.begin(), matched_documents.end(),
-			[](const Document& lhs, const Document& rhs) {
-				return (std::abs(lhs.relevance - rhs.relevance) < MAX_DIFF) ?
-					lhs.rating > rhs.rating : lhs.relevance > rhs.relevance;
-			});
+	ThreadPool& GetThreadPool() const;
 
-		//if matched documents amount is bigger than MAX_RESULT_DOCUMENT_COUNT constant - delete unnecessary docs
-		if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-			matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-		}
-		return matched_documents;
+	//every FindTopDocuments method returns not more than max_result_count best documents,
+	//they are selected with bounded heap, so there is no sorting of all found documents
+	template <typename DocumentPredicate>
+	std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+		return FindTopDocumentsWithCache(std::execution::seq, raw_query, document_predicate, max_result_count,
+			GetPredicateCacheKey<DocumentPredicate>());
 	}
 
-	std::vector<Document> FindTopDocuments(const std::string_view&, const DocumentStatus&) const;
+	std::vector<Document> FindTopDocuments(const std::string_view&, const DocumentStatus&,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+	//filter is pushed down: when it passes small part of documents, they are found by secondary indexes
+	//and only their postings are scored, other postings are skipped
+	std::vector<Document> FindTopDocuments(const std::string_view&, const DocumentFilter&,
+		size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
 	std::vector<Document> FindTopDocuments(const std::string_view&) const;
 
 	template <typename ExecutionPolicy, typename DocumentPredicate>
-	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
-		const std::string_view& raw_query, DocumentPredicate document_predicate) const {
+	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+		DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
 		//non-parallel version
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-			return FindTopDocuments(raw_query, document_predicate);
+		if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
+			return FindTopDocuments(raw_query, document_predicate, max_result_count);
 		}
 		else {
-			//using parallel methods for finding docs and their sorting
-
-			const auto query = ParseQuery(raw_query);
-
-			//getting all matched documents using custom or dafault predicate and parallel execution policy
-			auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-
-			//first sorting by relevance and if relevances are almost the same, then sort by rating
-			sort(std::execution::par, matched_documents.begin(), matched_documents.end(),
-				[](const Document& lhs, const Document& rhs) {
-					return (std::abs(lhs.relevance - rhs.relevance) < MAX_DIFF) ?
-						lhs.rating > rhs.rating : lhs.relevance > rhs.relevance;
-				});
+			//using parallel methods for finding docs and their selecting
+			return FindTopDocumentsWithCache(policy, raw_query, document_predicate, max_result_count,
+				GetPredicateCacheKey<DocumentPredicate>());
+		};
+	}
 
-			//if matched documents amount is bigger than MAX_RESULT_DOCUMENT_COUNT constant - delete unnecessary docs
-			if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-				matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-			}
-			return matched_documents;
+	template <typename ExecutionPolicy>
+	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+		const DocumentStatus& status, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+		if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
+			//non-parallel version
+			return FindTopDocuments(raw_query, status, max_result_count);
+		}
+		else {
+			return FindTopDocuments(policy, raw_query, DocumentFilter(status), max_result_count);
 		};
 	}
 
 	template <typename ExecutionPolicy>
-	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
-		const std::string_view& raw_query, const DocumentStatus& status) const {
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query,
+		const DocumentFilter& filter, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+		if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
 			//non-parallel version
-			return FindTopDocuments(raw_query, status);
+			return FindTopDocuments(raw_query, filter, max_result_count);
 		}
 		else {
-			//creating predicate with document status filtering
-			return FindTopDocuments(policy, raw_query, [status](int, DocumentStatus document_status, int) { return document_status == status; });
+			return FindTopDocumentsWithCache(policy, raw_query, filter, max_result_count, filter.GetCacheKey());
 		};
 	}
 
 	template <typename ExecutionPolicy>
 	std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view& raw_query) const {
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+		if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
 			//non-parallel version
 			return FindTopDocuments(raw_query);
 		}
@@ -126,35 +140,63 @@ public:
 
 	int GetDocumentCount() const;
 
+	//version of the index, it is changed by every adding or removing of documents
+	uint64_t GetIndexVersion() const;
+
+	//results of FindTopDocuments are cached for the given amount of the most recently used queries, 0 disables cache.
+	//Query is cached in normalized form: sorted plus and minus words without stop words and duplicates, together with
+	//status or type of predicate and amount of documents. Predicates with state (e.g. lambdas with captures)
+	//are not cached because results depend on the state. Predicate without members which reads global or other
+	//changing state gets stale results, it must not be used with cache. All results are dropped when the index is changed
+	void SetQueryCacheCapacity(size_t);
+
+	QueryCacheStats GetQueryCacheStats() const;
+
+	//durations of search stages and counters of scanned postings and scored documents (see search_metrics.h),
+	//copies of the server share them. Snapshot is empty if metrics are not compiled in
+	SearchMetricsSnapshot GetMetrics() const;
+
+	void ResetMetrics();
+
 	int GetDocumentId(int id) const;
 
 	auto begin()const {
-		return document_ids_.begin();
+		return documents_.begin();
 	}
 
 	auto end()const {
-		return document_ids_.end();
+		return documents_.end();
 	}
 
 	const std::map<std::string_view, double> GetWordFrequencies(int) const;
 
+	//calling func(term_id) for every word of the document in increasing order of ids, nothing is called
+	//if there is no such document. Equal words have equal ids, so documents can be compared by ids without strings
+	template <typename Function>
+	void ForEachDocumentTermId(int document_id, Function func) const {
+		const DocumentSlot slot = documents_.FindSlot(document_id);
+		if (slot != NO_SLOT) {
+			ForEachDocumentTerm(slot, [&func](TermId term_id, double) { func(term_id); });
+		};
+	}
+
 	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view&, int) const;
 
 	template <typename ExecutionPolicy>
 	std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
 		ExecutionPolicy, const std::string_view& raw_query, int document_id) const {
 		//non-parallel version
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+		if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
 			return MatchDocument(raw_query, document_id);
-		};
-
-		//throw exception if document with recieved id does not exist
-		if (document_ids_.count(document_id) == 0) {
-			throw std::out_of_range("Invalid id"s);
-		};
+		}
+		else {
+			//throw exception if document with recieved id does not exist
+			const DocumentSlot slot = documents_.FindSlot(document_id);
+			if (slot == NO_SLOT) {
+				throw std::out_of_range("Invalid id"s);
+			};
 
-		//version using parallel algorithms
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
+			//version using parallel algorithms
 			const auto query = ParseQuery(raw_query);
 
 			//creating vector for matched words with max size as maximum possible matching words(plus_words)
@@ -162,181 +204,587 @@ public:
 
 			//add all matched words to vector
 			std::transform(std::execution::par, query.plus_words.begin(), query.plus_words.end(),
-				matched_words.begin(), [&, this, document_id](const std::string& word) {
-					auto iter = word_to_document_freqs_.find(word);
-					return (iter != word_to_document_freqs_.end() && iter->second.count(document_id))
-						? std::string_view(iter->first) : ""sv;
+				matched_words.begin(), [this, slot](std::string_view word) {
+					const TermId term_id = terms_.FindTerm(word);
+					return IsTermInDocument(term_id, slot) ? terms_.GetTerm(term_id) : ""sv;
 				});
 
 			//if any of minus words exists in the document we are looking for matches, then clear all matched words
-			for (const std::string& word : query.minus_words) {
-				if (word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id)) {
+			for (const std::string_view word : query.minus_words) {
+				if (IsTermInDocument(terms_.FindTerm(word), slot)) {
 					matched_words.clear();
 					break;
 				}
 			}
-			return { matched_words, documents_.at(document_id).status };
+			return { matched_words, documents_.GetStatus(slot) };
 		};
 	}
 
+	//matching the query with many documents at once: the query is parsed and its words are found in dictionary once,
+	//then documents are checked by forward index in parallel. Results are written into matches in order of given ids,
+	//so the same buffer can be reused by next calls. Throws std::out_of_range if some document does not exist
+	void MatchDocuments(const std::string_view& raw_query, const std::vector<int>& document_ids,
+		std::vector<DocumentMatch>& matches) const;
+
+	//matching the query with all documents in order of ids
+	void MatchDocuments(const std::string_view& raw_query, std::vector<DocumentMatch>& matches) const;
+
 	void RemoveDocument(int);
 
+	//removing many documents at once: document frequency of every affected word is updated only once
+	//and index version is changed once. Ids of absent documents are ignored
+	void RemoveDocuments(const std::vector<int>&);
+
+	//words of removed documents are not stored in memory anymore when no other document has them,
+	//but their bytes are freed only by this method. Views returned by GetWordFrequencies
+	//and MatchDocument become invalid after it is called
+	void CompactTermStorage();
+
+	//amount of bytes which would be freed by CompactTermStorage
+	size_t GetUnusedTermBytes() const;
+
+	//compressing posting lists of all words: slots are stored as bit-packed gaps and term frequencies
+	//as codes of distinct values, so search results do not change. Blocks are decoded on the fly while searching,
+	//segments sealed later are compressed too
+	void CompressPostings();
+
+	//posting lists are split into segments which are sealed and merged while documents are added, postings of removed
+	//documents stay in segments until they are merged. This method merges all segments of every list into one
+	//and drops postings of removed documents, it can be called from time to time (e.g. after many removals)
+	void MergeSegments();
+
+	//amount of memory taken by posting lists
+	size_t GetPostingBytes() const;
+
+	//saving index into binary snapshot file, throws std::runtime_error if the file can not be written
+	void SaveSnapshot(const std::string&) const;
+
+	//opening server from snapshot file saved by SaveSnapshot. The file is mapped into memory and
+	//dictionary, posting lists and forward index are used right from it without reading them,
+	//so opening takes time proportional only to amount of words and documents, not postings.
+	//The server can be changed as usual, the file must not be changed while the server or its copies exist.
+	//Throws std::runtime_error if the file can not be opened or it is not a snapshot of supported version
+	static SearchServer OpenSnapshot(const std::string&);
+
 	template <typename ExecutionPolicy>
 	void RemoveDocument(ExecutionPolicy, int document_id) {
-		if (!document_ids_.count(document_id)) {
+		const DocumentSlot slot = documents_.FindSlot(document_id);
+		if (slot == NO_SLOT) {
 			return; //if there is no document with recieved id, then do nothing
 		};
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+		if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
 			RemoveDocument(document_id); //removing with non-parallel methods
-			return;
-		};
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
-			document_ids_.erase(document_ids_.find(document_id));
-			documents_.erase(documents_.find(document_id));
-
-			//using mutex and lock_guard to do removing correctly step-by-step
-			std::mutex map_mutex;
-			const auto& words_to_erase = document_words_freqs_.find(document_id)->second;
-			std::for_each(std::execution::par, words_to_erase.begin(), words_to_erase.end(),
-				[this, &map_mutex, document_id](const auto& word_and_freq) {
-					auto& id_freq_map = word_to_document_freqs_.find(word_and_freq.first)->second;
-					auto iter_to_erase = id_freq_map.find(document_id);
-					std::lock_guard guard(map_mutex);
-					id_freq_map.erase(iter_to_erase);
+		}
+		else {
+			documents_.Remove(document_id);
+			++index_version_;
+
+			std::vector<TermId> terms_to_erase;
+			ForEachDocumentTerm(slot, [&terms_to_erase](TermId term_id, double) {
+				terms_to_erase.push_back(term_id);
 				});
 
-			document_words_freqs_.erase(document_words_freqs_.find(document_id));
+			//postings stay in posting lists until they are merged, every word has its own counter,
+			//so they can be changed in parallel without locking
+			std::for_each(std::execution::par, terms_to_erase.begin(), terms_to_erase.end(),
+				[this](TermId term_id) {
+					--term_document_freqs_[term_id];
+					UpdateTermDocumentFreq(term_id);
+				});
+
+			RemoveUnusedTerms(slot);
+			document_terms_freqs_[slot].clear();
 		};
 	}
 private:
-	struct DocumentData {
-		int rating;
-		DocumentStatus status;
+	const std::set<std::string, std::less<>> stop_words_;
+	TermDictionary terms_; //every indexed word is stored here once, indexes below use its ids
+	std::vector<PostingList> term_postings_; //index of the vector is term id
+	std::vector<uint32_t> term_document_freqs_; //amount of not removed documents containing the word, index of the vector is term id
+	std::vector<double> term_log_document_freqs_; //logarithm of document frequency, index of the vector is term id
+	std::vector<std::map<TermId, double>> document_terms_freqs_; //index of the vector is document slot
+	DocumentTable documents_;
+	std::shared_ptr<ThreadPool> thread_pool_ = ThreadPool::GetDefault();
+	uint64_t index_version_ = 0;
+	mutable QueryCache query_cache_;
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+	std::shared_ptr<SearchMetrics> metrics_ = std::make_shared<SearchMetrics>();
+#endif
+
+	//forward index of documents opened from snapshot: words of the slot are in range [offsets[slot], offsets[slot + 1])
+	//sorted by id, documents added after opening are kept in document_terms_freqs_
+	struct MappedForwardIndex {
+		const uint64_t* offsets = nullptr;
+		const TermId* term_ids = nullptr;
+		const double* term_freqs = nullptr;
+		size_t slot_count = 0;
 	};
 
-	const std::set<std::string> stop_words_;
-	std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-	std::map<int, std::map<std::string, double>> document_words_freqs_;
-	std::map<int, DocumentData> documents_;
-	std::set<int> document_ids_;
+	MappedForwardIndex mapped_forward_;
+	std::shared_ptr<const MappedFile> snapshot_; //dictionary, posting lists and forward index point into it
 
-	bool IsStopWord(const std::string&) const;
+	//calling func(term_id, term_freq) for every word of the document in increasing order of ids
+	template <typename Function>
+	void ForEachDocumentTerm(DocumentSlot slot, Function func) const {
+		if (slot < mapped_forward_.slot_count) {
+			for (uint64_t i = mapped_forward_.offsets[slot]; i < mapped_forward_.offsets[slot + 1]; ++i) {
+				func(mapped_forward_.term_ids[i], mapped_forward_.term_freqs[i]);
+			};
+			return;
+		};
+		for (const auto& [term_id, term_freq] : document_terms_freqs_[slot]) {
+			func(term_id, term_freq);
+		};
+	}
 
-	static bool IsValidWord(const std::string&);
+	bool IsStopWord(std::string_view) const;
 
-	std::vector<std::string> SplitIntoWordsNoStop(const std::string_view&) const;
+	//returned words are views into the text
+	std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view&) const;
 
 	static int ComputeAverageRating(const std::vector<int>&);
 
 	struct QueryWord {
-		std::string data;
+		std::string_view data;
 		bool is_minus;
 		bool is_stop;
 	};
 
+	//words are views into the text of query, they are sorted and have no duplicates
 	struct Query {
-		std::set<std::string> plus_words;
-		std::set<std::string> minus_words;
+		std::vector<std::string_view> plus_words;
+		std::vector<std::string_view> minus_words;
 	};
 
-	QueryWord ParseQueryWord(const std::string&) const;
+	//second parameter tells if tokenizer has found special characters in the word
+	QueryWord ParseQueryWord(std::string_view, bool) const;
 
 	Query ParseQuery(const std::string_view&) const;
 
-	double ComputeWordInverseDocumentFreq(const std::string&) const;
+	//inverse document frequency is log(document_count / document_freq), logarithm of document frequency
+	//is cached for every word and updated when it changes, so only log(document_count) is computed per query
+	double ComputeTermInverseDocumentFreq(TermId, double log_document_count) const;
+
+	//updating cached logarithm of document frequency after it was changed
+	void UpdateTermDocumentFreq(TermId);
+
+	//predicate of slots of removed documents for dropping their postings while merging
+	PostingList::RemovedSlots GetRemovedSlots() const;
+
+	//sealing tail of the posting list into a new segment if the tail is full
+	void SealFullTail(TermId);
+
+	bool IsTermInDocument(TermId, DocumentSlot) const;
+
+	//removing words of the removed document from dictionary if they have no postings anymore
+	void RemoveUnusedTerms(DocumentSlot);
+
+	//words of query resolved to term ids, words which are not indexed are dropped
+	struct QueryTerms {
+		std::vector<std::pair<TermId, double>> plus_terms; //term id and its inverse document frequency
+		std::vector<TermId> minus_terms;
+	};
+
+	QueryTerms ResolveQuery(const Query&) const;
 
+	//key of predicate for query cache, empty if results of the predicate can not be cached.
+	//Predicate without state is identified by address of its type_info: names of types with internal linkage
+	//from different files can be equal, but every type has its own type_info object
 	template <typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-		std::map<int, double> document_to_relevance; //document id and relevance
-		for (const std::string& word : query.plus_words) {
-			if (word_to_document_freqs_.count(word)) {
-				//computing freq for each word
-				const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-
-				for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-					const auto& document_data = documents_.at(document_id);
-
-					//filter unnecessary docs using predicate
-					if (document_predicate(document_id, document_data.status, document_data.rating)) {
-						document_to_relevance[document_id] += term_freq * inverse_document_freq;
-					};
-				};
+	static std::string GetPredicateCacheKey() {
+		if constexpr (std::is_empty_v<DocumentPredicate>) {
+			return "predicate "s + std::to_string(reinterpret_cast<std::uintptr_t>(&typeid(DocumentPredicate)));
+		}
+		else {
+			return {};
+		};
+	}
+
+	std::string GetQueryCacheKey(const Query&, const std::string& predicate_key, size_t max_result_count) const;
+
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	std::vector<Document> FindTopDocumentsWithCache(const ExecutionPolicy& policy, const std::string_view& raw_query,
+		DocumentPredicate document_predicate, size_t max_result_count, const std::string& predicate_key) const {
+		SEARCH_METRICS_STAGE(*metrics_, SearchStage::QUERY);
+		SEARCH_METRICS_COUNT(*metrics_, SearchCounter::QUERIES, 1);
+		const auto query = ParseQuery(raw_query);
+
+		std::string cache_key;
+		if (query_cache_.IsEnabled() && !predicate_key.empty()) {
+			cache_key = GetQueryCacheKey(query, predicate_key, max_result_count);
+			if (auto cached_documents = query_cache_.Find(cache_key, index_version_)) {
+				return std::move(*cached_documents);
 			};
 		};
 
-		//erase all documents which contain minus words from result
-		for (const std::string& word : query.minus_words) {
-			if (word_to_document_freqs_.count(word)) {
-				for (const auto& [document_id, _] : word_to_document_freqs_.at(word)) {
-					document_to_relevance.erase(document_id);
-				};
+		//getting best matched documents using custom or dafault predicate
+		TopDocuments top_documents(max_result_count);
+		const auto find_all_documents = [&](const auto& predicate) {
+			if constexpr (IS_SEQUENCED_POLICY<ExecutionPolicy>) {
+				FindAllDocuments(query, predicate, top_documents);
+			}
+			else {
+				FindAllDocuments(policy, query, predicate, top_documents);
 			};
 		};
+		//specialized predicates are cheap and they have to keep their types to be recognized by kernels,
+		//so only calls of arbitrary predicates are measured
+		if constexpr (DocumentPredicateTraits<DocumentPredicate>::KIND != DocumentPredicateKind::ARBITRARY) {
+			find_all_documents(document_predicate);
+		}
+		else {
+			find_all_documents(SEARCH_METRICS_MEASURE_PREDICATE(*metrics_, document_predicate));
+		};
+		std::vector<Document> documents;
+		{
+			SEARCH_METRICS_STAGE(*metrics_, SearchStage::TOP_K);
+			documents = top_documents.Extract();
+		}
 
-		//creating vector of Document data for all valid results
-		std::vector<Document> matched_documents;
-		for (const auto& [document_id, relevance] : document_to_relevance) {
-			matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+		if (!cache_key.empty()) {
+			query_cache_.Insert(cache_key, index_version_, documents);
+		};
+		return documents;
+	}
+
+	//parallel search splits slots into parts not smaller than this constant, one part for each thread
+	static constexpr size_t MIN_SLOTS_PER_PART = 4096;
+
+	//AddDocuments splits documents into parts not smaller than this constant, one part for each thread
+	static constexpr size_t MIN_DOCUMENTS_PER_PART = 64;
+
+	//queries with at least this amount of plus words are evaluated document-at-a-time with MaxScore pruning
+	static constexpr size_t MIN_PLUS_TERMS_FOR_MAX_SCORE = 2;
+
+	//upper bound of document score is compared with the worst kept document with this margin for rounding errors
+	static constexpr double MAX_SCORE_EPSILON = 1e-9;
+
+	//filter is pushed down when it passes not more than this share of documents and postings of the query
+	//are at least PUSHDOWN_POSTINGS_PER_SLOT times more than documents passing it. Otherwise checking documents
+	//of all postings is cheaper than finding allowed slots and jumping between them
+	static constexpr double MAX_PUSHDOWN_FILTER_SHARE = 0.125;
+	static constexpr size_t PUSHDOWN_POSTINGS_PER_SLOT = 4;
+
+	//sorted slots of documents passed by the predicate if it is a filter selective enough to be pushed down
+	template <typename DocumentPredicate>
+	std::optional<std::vector<DocumentSlot>> FindAllowedSlots(const DocumentPredicate& document_predicate,
+		const QueryTerms& query_terms) const {
+		if constexpr (std::is_same_v<DocumentPredicate, DocumentFilter>) {
+			const size_t allowed_count = documents_.CountFilterUpperBound(document_predicate);
+			if (allowed_count > documents_.size() * MAX_PUSHDOWN_FILTER_SHARE) {
+				return std::nullopt;
+			};
+			size_t posting_count = 0;
+			for (const auto& [term_id, inverse_document_freq] : query_terms.plus_terms) {
+				posting_count += term_postings_[term_id].size();
+			};
+			for (const TermId term_id : query_terms.minus_terms) {
+				posting_count += term_postings_[term_id].size();
+			};
+			if (posting_count >= allowed_count * PUSHDOWN_POSTINGS_PER_SLOT) {
+				return documents_.FindSlots(document_predicate);
+			};
+		};
+		return std::nullopt;
+	}
+
+	//calling func(slot, term_freq) for postings with slots in range [begin_slot, end_slot) which are in allowed_slots,
+	//for all of them if allowed_slots is null. Postings and allowed slots are both sorted, so each of them
+	//jumps to the current slot of the other one and postings of not allowed documents are skipped
+	template <typename Function>
+	void ForEachAllowedPosting(const PostingList& postings, const std::vector<DocumentSlot>* allowed_slots,
+		DocumentSlot begin_slot, DocumentSlot end_slot, Function func) const {
+		if (allowed_slots == nullptr) {
+			postings.ForEachInRange(begin_slot, end_slot, func);
+			return;
+		};
+		auto allowed = std::lower_bound(allowed_slots->begin(), allowed_slots->end(), begin_slot);
+		PostingList::Cursor cursor(postings);
+		while (allowed != allowed_slots->end() && *allowed < end_slot) {
+			cursor.SeekTo(*allowed);
+			if (cursor.GetSlot() >= end_slot) {
+				break;
+			};
+			if (cursor.GetSlot() == *allowed) {
+				func(*allowed, cursor.GetTermFreq());
+				++allowed;
+			}
+			else {
+				allowed = std::lower_bound(allowed, allowed_slots->end(), cursor.GetSlot());
+			};
+		};
+	}
+
+	//calling func(is_slot_passed) with check of document by slot which is specialized for kind of the predicate
+	//at compile time. Removed documents never pass it. Documents passing any predicate are checked only by tombstones,
+	//filter is checked by one byte of status codes (and rating if the filter has range) without branches,
+	//arbitrary predicate gets id, status and rating of the document
+	template <typename DocumentPredicate, typename Function>
+	void WithSlotPredicate(const DocumentPredicate& document_predicate, Function func) const {
+		constexpr DocumentPredicateKind kind = DocumentPredicateTraits<DocumentPredicate>::KIND;
+		if constexpr (kind == DocumentPredicateKind::ANY) {
+			func([this](DocumentSlot slot) {
+				return !documents_.IsRemoved(slot);
+				});
+		}
+		else if constexpr (kind == DocumentPredicateKind::FILTER) {
+			//status code of removed document has no bit in the mask
+			const uint32_t status_mask = document_predicate.GetStatusMask();
+			const uint8_t* const status_codes = documents_.GetStatusCodes();
+			if (!document_predicate.HasRatingRange()) {
+				func([status_mask, status_codes](DocumentSlot slot) {
+					return ((status_mask >> status_codes[slot]) & 1) != 0;
+					});
+			}
+			else if (document_predicate.GetMinRating() <= document_predicate.GetMaxRating()) {
+				//rating is in range when its unsigned distance from minimum is not bigger than width of the range
+				const uint32_t min_rating = static_cast<uint32_t>(document_predicate.GetMinRating());
+				const uint32_t rating_range = static_cast<uint32_t>(document_predicate.GetMaxRating()) - min_rating;
+				func([this, status_mask, status_codes, min_rating, rating_range](DocumentSlot slot) {
+					return (((status_mask >> status_codes[slot]) & 1)
+						& (static_cast<uint32_t>(documents_.GetRating(slot)) - min_rating <= rating_range)) != 0;
+					});
+			}
+			else {
+				func([](DocumentSlot) {
+					return false;
+					});
+			};
 		}
-		return matched_documents;
+		else {
+			func([this, &document_predicate](DocumentSlot slot) {
+				return !documents_.IsRemoved(slot)
+					&& document_predicate(documents_.GetId(slot), documents_.GetStatus(slot), documents_.GetRating(slot));
+				});
+		};
 	}
 
-	template <typename ExecutionPolicy, typename DocumentPredicate>
-	std::vector<Document> FindAllDocuments(const ExecutionPolicy& policy,
-		const Query& query, DocumentPredicate document_predicate) const {
-		if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-			return FindAllDocuments(query, document_predicate); //non-parallel method
+	//scoring only documents with slots in range [begin_slot, end_slot), so different ranges can be processed
+	//by different threads independently: each of them has its own accumulator and heap of the best documents.
+	//If allowed_slots is not null, only these documents are scored
+	template <typename SlotPredicate>
+	void FindDocumentsInRange(const QueryTerms& query_terms, SlotPredicate is_slot_passed,
+		const std::vector<DocumentSlot>* allowed_slots, DocumentSlot begin_slot, DocumentSlot end_slot,
+		TopDocuments& top_documents) const {
+		if (query_terms.plus_terms.size() >= MIN_PLUS_TERMS_FOR_MAX_SCORE) {
+			FindDocumentsInRangeMaxScore(query_terms, is_slot_passed, allowed_slots, begin_slot, end_slot, top_documents);
+		}
+		else {
+			FindDocumentsInRangeExhaustive(query_terms, is_slot_passed, allowed_slots, begin_slot, end_slot, top_documents);
 		};
+	}
+
+	//term-at-a-time scoring of all postings of plus words
+	template <typename SlotPredicate>
+	void FindDocumentsInRangeExhaustive(const QueryTerms& query_terms, SlotPredicate is_slot_passed,
+		const std::vector<DocumentSlot>* allowed_slots, DocumentSlot begin_slot, DocumentSlot end_slot,
+		TopDocuments& top_documents) const {
+		//relevances are accumulated in flat array of the thread indexed by slot, it is reused between queries
+		ScoreAccumulator& accumulator = ScoreAccumulator::ForCurrentThread();
+		accumulator.Reset(documents_.GetSlotCount());
+
+		LocalSearchCounter scanned_postings;
+		LocalSearchCounter scored_candidates;
 
-		//creating ConcurrentMap, it guaranties correct adding and removing elements while multithreading 
-		ConcurrentMap<int, double> conc_map(4);
+		//marking all documents which contain minus words, they will be skipped while scoring
 		{
-			std::vector<std::future<void>> operations;
-			//creating kernel to process word
-			auto kernel = [this, &conc_map, document_predicate](const std::string& word) {
-				if (word_to_document_freqs_.count(word)) {
-					const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-					for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-						const auto& document_data = documents_.at(document_id);
-						if (document_predicate(document_id, document_data.status, document_data.rating)) {
-							conc_map[document_id] += term_freq * inverse_document_freq;
-						};
+			SEARCH_METRICS_STAGE(*metrics_, SearchStage::MINUS_FILTER);
+			for (const TermId term_id : query_terms.minus_terms) {
+				ForEachAllowedPosting(term_postings_[term_id], allowed_slots, begin_slot, end_slot, [&](DocumentSlot slot, double) {
+					++scanned_postings;
+					accumulator.Exclude(slot);
+					});
+			};
+		}
+
+		{
+			SEARCH_METRICS_STAGE(*metrics_, SearchStage::POSTING_SCAN);
+			for (const auto& [term_id, inverse_document_freq] : query_terms.plus_terms) {
+				ForEachAllowedPosting(term_postings_[term_id], allowed_slots, begin_slot, end_slot,
+					[&](DocumentSlot slot, double term_freq) {
+					++scanned_postings;
+					//filter unnecessary docs using predicate, documents data is read from arrays by slot
+					if (!accumulator.IsExcluded(slot) && is_slot_passed(slot)) {
+						accumulator.Add(slot, term_freq * inverse_document_freq);
 					};
+					});
+			};
+		}
+
+		//pushing all valid results, only the best of them will be kept
+		{
+			SEARCH_METRICS_STAGE(*metrics_, SearchStage::TOP_K);
+			accumulator.ForEach([&](DocumentSlot slot, double relevance) {
+				++scored_candidates;
+				top_documents.Push({ documents_.GetId(slot), relevance, documents_.GetRating(slot) });
+				});
+		}
+		SEARCH_METRICS_COUNT(*metrics_, SearchCounter::POSTINGS_SCANNED, scanned_postings.Get());
+		SEARCH_METRICS_COUNT(*metrics_, SearchCounter::CANDIDATES_SCORED, scored_candidates.Get());
+	}
+
+	//document-at-a-time scoring with MaxScore. Words are sorted by upper bound of their score (maximal term frequency
+	//multiplied by inverse document frequency). When the heap is full, words which all together can not reach
+	//the worst kept document become non-essential: only documents containing essential words are candidates
+	//and cursors of non-essential words jump over postings between candidates. Candidate is dropped as soon as
+	//its upper bound is lower than relevance of the worst kept document by more than MAX_DIFF, such document
+	//would not be kept anyway, so results are the same as of exhaustive scoring
+	template <typename SlotPredicate>
+	void FindDocumentsInRangeMaxScore(const QueryTerms& query_terms, SlotPredicate is_slot_passed,
+		const std::vector<DocumentSlot>* allowed_slots, DocumentSlot begin_slot, DocumentSlot end_slot,
+		TopDocuments& top_documents) const {
+		struct TermCursor {
+			PostingList::Cursor cursor;
+			double inverse_document_freq;
+			double max_score;
+			size_t query_index; //scores of words are summed in order of the query as in exhaustive scoring
+		};
+		//minus words are checked only for candidates, so their time is a part of posting scan
+		SEARCH_METRICS_STAGE(*metrics_, SearchStage::POSTING_SCAN);
+		LocalSearchCounter scanned_postings;
+		LocalSearchCounter scored_candidates;
+		std::vector<TermCursor> plus_cursors;
+		plus_cursors.reserve(query_terms.plus_terms.size());
+		for (size_t query_index = 0; query_index < query_terms.plus_terms.size(); ++query_index) {
+			const auto& [term_id, inverse_document_freq] = query_terms.plus_terms[query_index];
+			const PostingList& postings = term_postings_[term_id];
+			plus_cursors.push_back({ PostingList::Cursor(postings), inverse_document_freq,
+				postings.GetMaxTermFreq() * inverse_document_freq, query_index });
+			plus_cursors.back().cursor.SeekTo(begin_slot);
+		};
+		std::sort(plus_cursors.begin(), plus_cursors.end(),
+			[](const TermCursor& lhs, const TermCursor& rhs) { return lhs.max_score < rhs.max_score; });
+		std::vector<double> bound_sums(plus_cursors.size()); //upper bound of total score of words [0, i]
+		for (size_t i = 0; i < plus_cursors.size(); ++i) {
+			bound_sums[i] = plus_cursors[i].max_score + (i > 0 ? bound_sums[i - 1] : 0.0);
+		};
+
+		std::vector<PostingList::Cursor> minus_cursors;
+		minus_cursors.reserve(query_terms.minus_terms.size());
+		for (const TermId term_id : query_terms.minus_terms) {
+			minus_cursors.emplace_back(term_postings_[term_id]);
+		};
+
+		const auto can_not_be_kept = [&top_documents](double upper_bound) {
+			return top_documents.IsFull() && top_documents.size() > 0
+				&& upper_bound + MAX_SCORE_EPSILON < top_documents.GetWorst().relevance - MAX_DIFF;
+		};
+		std::vector<double> term_scores(plus_cursors.size()); //scores of the candidate indexed by position in the query
+		size_t first_essential = 0; //words before it are non-essential
+		std::vector<DocumentSlot>::const_iterator allowed; //the first allowed slot which is not less than candidate
+		if (allowed_slots != nullptr) {
+			allowed = std::lower_bound(allowed_slots->begin(), allowed_slots->end(), begin_slot);
+		};
+		while (true) {
+			while (first_essential < plus_cursors.size() && can_not_be_kept(bound_sums[first_essential])) {
+				++first_essential;
+			};
+			DocumentSlot candidate = NO_SLOT;
+			for (size_t i = first_essential; i < plus_cursors.size(); ++i) {
+				candidate = std::min(candidate, plus_cursors[i].cursor.GetSlot());
+			};
+			if (candidate >= end_slot) {
+				break; //also when all words became non-essential or all postings are passed
+			};
+			//essential cursors jump to the next allowed document without reading postings between
+			if (allowed_slots != nullptr) {
+				allowed = std::lower_bound(allowed, allowed_slots->end(), candidate);
+				const DocumentSlot allowed_slot = allowed == allowed_slots->end() ? NO_SLOT : *allowed;
+				if (allowed_slot >= end_slot) {
+					break;
+				};
+				if (allowed_slot != candidate) {
+					for (size_t i = first_essential; i < plus_cursors.size(); ++i) {
+						plus_cursors[i].cursor.SeekTo(allowed_slot);
+					};
+					continue;
 				};
 			};
 
-			//starting kernels
-			for (const std::string& word : query.plus_words) {
-				operations.push_back(std::async(kernel, word));
+			std::fill(term_scores.begin(), term_scores.end(), 0.0);
+			double upper_bound = first_essential > 0 ? bound_sums[first_essential - 1] : 0.0;
+			for (size_t i = first_essential; i < plus_cursors.size(); ++i) {
+				TermCursor& term_cursor = plus_cursors[i];
+				if (term_cursor.cursor.GetSlot() == candidate) {
+					term_scores[term_cursor.query_index] = term_cursor.cursor.GetTermFreq() * term_cursor.inverse_document_freq;
+					upper_bound += term_scores[term_cursor.query_index];
+					term_cursor.cursor.Next();
+					++scanned_postings;
+				};
+			};
+			if (documents_.IsRemoved(candidate)) {
+				continue; //posting of removed document which is not merged yet
 			};
-		} //when we will exit this namespace, all results of kernels would be gotten automatically
-
-		//erase all documents which contain minus words from result
-		std::for_each(policy, query.minus_words.begin(), query.minus_words.end(),
-			[this, &conc_map, &policy](const std::string& word) {
-				if (word_to_document_freqs_.count(word)) {
-					auto& words_freq_map = word_to_document_freqs_.at(word);
-					std::for_each(policy, words_freq_map.begin(), words_freq_map.end(),
-						[&conc_map](const std::pair<const int, double>& pair_obj) {
-							conc_map.erase(pair_obj.first);
-						});
+			//upper bounds of non-essential words are replaced with their real scores starting from the biggest one
+			for (size_t i = first_essential; i > 0 && !can_not_be_kept(upper_bound); --i) {
+				TermCursor& term_cursor = plus_cursors[i - 1];
+				upper_bound -= term_cursor.max_score;
+				term_cursor.cursor.SeekTo(candidate);
+				++scanned_postings;
+				if (term_cursor.cursor.GetSlot() == candidate) {
+					term_scores[term_cursor.query_index] = term_cursor.cursor.GetTermFreq() * term_cursor.inverse_document_freq;
+					upper_bound += term_scores[term_cursor.query_index];
 				};
+			};
+			if (can_not_be_kept(upper_bound)) {
+				continue;
+			};
+
+			const bool has_minus_word = std::any_of(minus_cursors.begin(), minus_cursors.end(),
+				[candidate](PostingList::Cursor& cursor) {
+					cursor.SeekTo(candidate);
+					return cursor.GetSlot() == candidate;
+				});
+			if (has_minus_word || !is_slot_passed(candidate)) {
+				continue;
+			};
+			double relevance = 0.0;
+			for (const double term_score : term_scores) {
+				relevance += term_score;
+			};
+			++scored_candidates;
+			top_documents.Push({ documents_.GetId(candidate), relevance, documents_.GetRating(candidate) });
+		};
+		SEARCH_METRICS_COUNT(*metrics_, SearchCounter::POSTINGS_SCANNED, scanned_postings.Get());
+		SEARCH_METRICS_COUNT(*metrics_, SearchCounter::CANDIDATES_SCORED, scored_candidates.Get());
+	}
+
+	template <typename DocumentPredicate>
+	void FindAllDocuments(const Query& query, DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+		const QueryTerms query_terms = ResolveQuery(query);
+		const auto allowed_slots = FindAllowedSlots(document_predicate, query_terms);
+		WithSlotPredicate(document_predicate, [&](auto is_slot_passed) {
+			FindDocumentsInRange(query_terms, is_slot_passed, allowed_slots ? &*allowed_slots : nullptr,
+				0, static_cast<DocumentSlot>(documents_.GetSlotCount()), top_documents);
 			});
-		//creating map using method of ConcurrentMap
-		std::map<int, double> document_to_relevance = conc_map.BuildOrdinaryMap();
-		std::mutex matched_documents_mutex;
-		std::vector<Document> matched_documents;
-		std::for_each(policy, document_to_relevance.begin(), document_to_relevance.end(),
-			[this, &matched_documents, &matched_documents_mutex](const std::pair<const int, double>& pair_obj) {
-				Document* ref{};
-				{
-					//locking only for creating place for element to get maximum perfomance
-					std::lock_guard guard(matched_documents_mutex);
-					ref = &matched_documents.emplace_back();
-				}
-				*ref = { pair_obj.first, pair_obj.second, documents_.at(pair_obj.first).rating };
+	}
+
+	template <typename ExecutionPolicy, typename DocumentPredicate>
+	void FindAllDocuments(const ExecutionPolicy&, const Query& query, DocumentPredicate document_predicate,
+		TopDocuments& top_documents) const {
+		const QueryTerms query_terms = ResolveQuery(query);
+		const auto allowed_slots = FindAllowedSlots(document_predicate, query_terms);
+
+		//slots are split into ranges, every thread scans postings only of its range without any locking
+		const size_t slot_count = documents_.GetSlotCount();
+		const size_t part_count = std::clamp<size_t>(slot_count / MIN_SLOTS_PER_PART, 1, thread_pool_->GetWorkerCount() + 1);
+		const size_t part_size = (slot_count + part_count - 1) / part_count;
+
+		std::vector<TopDocuments> parts_top(part_count, top_documents); //copies of empty heap with the same limit
+		WithSlotPredicate(document_predicate, [&](auto is_slot_passed) {
+			thread_pool_->ParallelFor(part_count, [&](size_t part) {
+				const DocumentSlot begin_slot = static_cast<DocumentSlot>(std::min(slot_count, part * part_size));
+				const DocumentSlot end_slot = static_cast<DocumentSlot>(std::min(slot_count, begin_slot + part_size));
+				FindDocumentsInRange(query_terms, is_slot_passed, allowed_slots ? &*allowed_slots : nullptr,
+					begin_slot, end_slot, parts_top[part]);
+				});
 			});
-		return matched_documents;
+
+		//every part keeps not more than needed amount of documents, so merging them is cheap
+		SEARCH_METRICS_STAGE(*metrics_, SearchStage::TOP_K);
+		for (const TopDocuments& part_top : parts_top) {
+			top_documents.Merge(part_top);
+		};
 	}
 };
 
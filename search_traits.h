@@ -0,0 +1,39 @@
+#pragma once
+#include <execution>
+#include <type_traits>
+
+#include "document.h"
+#include "document_filter.h"
+
+//true for std::execution::seq, methods of the server run in parallel with any other policy
+template <typename ExecutionPolicy>
+inline constexpr bool IS_SEQUENCED_POLICY = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>;
+
+//predicate passing every document, search with it checks only that documents are not removed
+struct AnyDocument {
+	bool operator()(int, DocumentStatus, int) const {
+		return true;
+	}
+};
+
+//shapes of predicates which search kernels are specialized for at compile time
+enum class DocumentPredicateKind {
+	ANY, //AnyDocument
+	FILTER, //DocumentFilter, checked by precomputed status codes and ratings of slots
+	ARBITRARY, //any other callable, it gets id, status and rating of every document
+};
+
+template <typename DocumentPredicate>
+struct DocumentPredicateTraits {
+	static constexpr DocumentPredicateKind KIND = DocumentPredicateKind::ARBITRARY;
+};
+
+template <>
+struct DocumentPredicateTraits<AnyDocument> {
+	static constexpr DocumentPredicateKind KIND = DocumentPredicateKind::ANY;
+};
+
+template <>
+struct DocumentPredicateTraits<DocumentFilter> {
+	static constexpr DocumentPredicateKind KIND = DocumentPredicateKind::FILTER;
+};
@@ -0,0 +1,113 @@
+#include "slot_bitmap.h"
+
+#include <algorithm>
+
+namespace {
+	const uint32_t LOW_BITS_MASK = (uint32_t{1} << SlotBitmap::CHUNK_BITS) - 1;
+	const size_t CHUNK_WORD_COUNT = (size_t{1} << SlotBitmap::CHUNK_BITS) / 64;
+}
+
+void SlotBitmap::Add(uint32_t slot) {
+	const uint32_t key = slot >> CHUNK_BITS;
+	const uint16_t low_bits = static_cast<uint16_t>(slot & LOW_BITS_MASK);
+	auto chunk = FindChunk(key);
+	if (chunk == chunks_.end() || chunk->key != key) {
+		chunk = chunks_.insert(chunk, Chunk());
+		chunk->key = key;
+	};
+	++chunk->size;
+	++size_;
+	if (chunk->IsBitmap()) {
+		chunk->bits[low_bits / 64] |= uint64_t{1} << (low_bits % 64);
+		return;
+	};
+	if (chunk->array.empty() || chunk->array.back() < low_bits) {
+		chunk->array.push_back(low_bits);
+	}
+	else {
+		chunk->array.insert(std::lower_bound(chunk->array.begin(), chunk->array.end(), low_bits), low_bits);
+	};
+	//array became bigger than bitmap, so chunk is converted
+	if (chunk->array.size() > MAX_ARRAY_SIZE) {
+		chunk->bits.assign(CHUNK_WORD_COUNT, 0);
+		for (const uint16_t value : chunk->array) {
+			chunk->bits[value / 64] |= uint64_t{1} << (value % 64);
+		};
+		chunk->array = std::vector<uint16_t>();
+	};
+}
+
+void SlotBitmap::Remove(uint32_t slot) {
+	const uint32_t key = slot >> CHUNK_BITS;
+	const uint16_t low_bits = static_cast<uint16_t>(slot & LOW_BITS_MASK);
+	const auto chunk = FindChunk(key);
+	if (chunk == chunks_.end() || chunk->key != key) {
+		return;
+	};
+	if (chunk->IsBitmap()) {
+		uint64_t& word = chunk->bits[low_bits / 64];
+		const uint64_t bit = uint64_t{1} << (low_bits % 64);
+		if ((word & bit) == 0) {
+			return;
+		};
+		word &= ~bit;
+	}
+	else {
+		const auto iter = std::lower_bound(chunk->array.begin(), chunk->array.end(), low_bits);
+		if (iter == chunk->array.end() || *iter != low_bits) {
+			return;
+		};
+		chunk->array.erase(iter);
+	};
+	--chunk->size;
+	--size_;
+	if (chunk->size == 0) {
+		chunks_.erase(chunk);
+		return;
+	};
+	//bitmap became sparse, so chunk is converted back
+	if (chunk->IsBitmap() && chunk->size <= MAX_ARRAY_SIZE) {
+		chunk->array.reserve(chunk->size);
+		for (size_t word_index = 0; word_index < chunk->bits.size(); ++word_index) {
+			for (uint64_t word = chunk->bits[word_index]; word != 0; word &= word - 1) {
+				chunk->array.push_back(static_cast<uint16_t>(word_index * 64 + __builtin_ctzll(word)));
+			};
+		};
+		chunk->bits = std::vector<uint64_t>();
+	};
+}
+
+bool SlotBitmap::Contains(uint32_t slot) const {
+	const uint32_t key = slot >> CHUNK_BITS;
+	const uint16_t low_bits = static_cast<uint16_t>(slot & LOW_BITS_MASK);
+	const auto chunk = FindChunk(key);
+	if (chunk == chunks_.end() || chunk->key != key) {
+		return false;
+	};
+	if (chunk->IsBitmap()) {
+		return (chunk->bits[low_bits / 64] >> (low_bits % 64)) & 1;
+	};
+	return std::binary_search(chunk->array.begin(), chunk->array.end(), low_bits);
+}
+
+size_t SlotBitmap::GetMemoryUsage() const {
+	size_t memory = chunks_.capacity() * sizeof(Chunk);
+	for (const Chunk& chunk : chunks_) {
+		memory += chunk.array.capacity() * sizeof(uint16_t) + chunk.bits.capacity() * sizeof(uint64_t);
+	};
+	return memory;
+}
+
+std::vector<SlotBitmap::Chunk>::iterator SlotBitmap::FindChunk(uint32_t key) {
+	//slots are mostly added to the last chunk
+	if (!chunks_.empty() && chunks_.back().key == key) {
+		return chunks_.end() - 1;
+	};
+	return std::lower_bound(chunks_.begin(), chunks_.end(), key,
+		[](const Chunk& chunk, uint32_t chunk_key) { return chunk.key < chunk_key; });
+}
+
+std::vector<SlotBitmap::Chunk>::const_iterator SlotBitmap::FindChunk(uint32_t key) const {
+	return std::lower_bound(chunks_.begin(), chunks_.end(), key,
+		[](const Chunk& chunk, uint32_t chunk_key) { return chunk.key < chunk_key; });
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//set of document slots in roaring style: slots are split into chunks of 2^16 by their upper bits, every chunk keeps
+//lower 16 bits of its slots as sorted array while it has not more than MAX_ARRAY_SIZE of them and as bitmap of 2^16 bits
+//when it has more. So sparse sets take 2 bytes per slot and dense sets 1 bit per slot.
+//Slots are usually added in increasing order, then adding is appending to the last chunk
+class SlotBitmap {
+public:
+	static constexpr size_t CHUNK_BITS = 16;
+	static constexpr size_t MAX_ARRAY_SIZE = 4096; //array of this size takes as much memory as bitmap
+
+	//adding slot which is not in the set yet
+	void Add(uint32_t slot);
+
+	//removing slot, nothing is done if it is not in the set
+	void Remove(uint32_t slot);
+
+	bool Contains(uint32_t slot) const;
+
+	size_t size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	size_t GetMemoryUsage() const;
+
+	//calling func(slot) for every slot in increasing order
+	template <typename Function>
+	void ForEach(Function func) const {
+		for (const Chunk& chunk : chunks_) {
+			const uint32_t high_bits = chunk.key << CHUNK_BITS;
+			if (!chunk.IsBitmap()) {
+				for (const uint16_t low_bits : chunk.array) {
+					func(high_bits | low_bits);
+				};
+				continue;
+			};
+			for (size_t word_index = 0; word_index < chunk.bits.size(); ++word_index) {
+				for (uint64_t word = chunk.bits[word_index]; word != 0; word &= word - 1) {
+					func(high_bits | static_cast<uint32_t>(word_index * 64 + __builtin_ctzll(word)));
+				};
+			};
+		};
+	}
+
+private:
+	struct Chunk {
+		uint32_t key = 0; //upper bits of slots
+		size_t size = 0;
+		std::vector<uint16_t> array; //used while bits are empty
+		std::vector<uint64_t> bits;
+
+		bool IsBitmap() const {
+			return !bits.empty();
+		}
+	};
+
+	std::vector<Chunk> chunks_; //sorted by key
+	size_t size_ = 0;
+
+	//chunk with the key or position where it should be inserted
+	std::vector<Chunk>::iterator FindChunk(uint32_t key);
+
+	std::vector<Chunk>::const_iterator FindChunk(uint32_t key) const;
+};
@@ -1,25 +1,87 @@
 #include "string_processing.h"
 
-std::vector<std::string> SplitIntoWords(const std::string_view& text_view) {
-	std::vector<std::string> words{};
-	std::string word{};
-	for (const char c : text_view) {
-		if (c == ' ') {
-			if (!word.empty()) {
-				words.push_back(word);
-				word.clear();
-			}
-		}
-		else {
-			word += c;
-		}
+#include "platform.h"
+
+#ifdef SEARCH_SERVER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	bool IsSpecialChar(char c) {
+		return c >= '\0' && c < ' ';
+	}
+
+#ifdef SEARCH_SERVER_HAS_SSE2
+	const size_t SIMD_BLOCK_SIZE = 16;
+
+	//bit i of the mask is set if character i of the block is a space
+	unsigned SpacesMask(__m128i block) {
+		return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(' '))));
+	}
+
+	//bit i of the mask is set if character i of the block is special, characters are compared as signed,
+	//so bytes of multibyte UTF-8 characters are negative and are not special
+	unsigned SpecialCharsMask(__m128i block) {
+		const __m128i is_not_negative = _mm_cmpgt_epi8(block, _mm_set1_epi8(-1));
+		const __m128i is_less_than_space = _mm_cmplt_epi8(block, _mm_set1_epi8(' '));
+		return static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(is_not_negative, is_less_than_space)));
+	}
+
+	__m128i LoadBlock(const char* data) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
 	}
-	if (!word.empty()) {
+#endif
+}
+
+size_t SkipSpaces(std::string_view text, size_t pos) {
+#ifdef SEARCH_SERVER_HAS_SSE2
+	for (; pos + SIMD_BLOCK_SIZE <= text.size(); pos += SIMD_BLOCK_SIZE) {
+		const unsigned not_spaces = ~SpacesMask(LoadBlock(text.data() + pos)) & 0xFFFFu;
+		if (not_spaces != 0) {
+			return pos + CountTrailingZeros(not_spaces);
+		};
+	};
+#endif
+	while (pos < text.size() && text[pos] == ' ') {
+		++pos;
+	};
+	return pos;
+}
+
+size_t FindWordEnd(std::string_view text, size_t pos, bool& has_special_chars) {
+#ifdef SEARCH_SERVER_HAS_SSE2
+	for (; pos + SIMD_BLOCK_SIZE <= text.size(); pos += SIMD_BLOCK_SIZE) {
+		const __m128i block = LoadBlock(text.data() + pos);
+		const unsigned spaces = SpacesMask(block);
+		const unsigned special_chars = SpecialCharsMask(block);
+		if (spaces != 0) {
+			const unsigned word_length = CountTrailingZeros(spaces);
+			//only characters before the space belong to the word
+			has_special_chars = has_special_chars || (special_chars & ((1u << word_length) - 1)) != 0;
+			return pos + word_length;
+		};
+		has_special_chars = has_special_chars || special_chars != 0;
+	};
+#endif
+	for (; pos < text.size() && text[pos] != ' '; ++pos) {
+		has_special_chars = has_special_chars || IsSpecialChar(text[pos]);
+	};
+	return pos;
+}
+
+bool IsValidWord(std::string_view word) {
+	bool has_special_chars = false;
+	//spaces are allowed here, so search goes on after the end of every part
+	for (size_t pos = 0; pos < word.size(); ++pos) {
+		pos = FindWordEnd(word, pos, has_special_chars);
+	};
+	return !has_special_chars;
+}
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+	std::vector<std::string_view> words;
+	for (const std::string_view word : WordsRange(text)) {
 		words.push_back(word);
 	}
 	return words;
 }
-
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-	return SplitIntoWords(std::string_view(text));
-}
\ No newline at end of file
@@ -1,20 +1,105 @@
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <iterator>
 #include <vector>
 #include <set>
 #include <string>
 #include <string_view>
 
-std::vector<std::string> SplitIntoWords(const std::string_view&);
+//returns position of the first character which is not a space, starting from pos
+size_t SkipSpaces(std::string_view text, size_t pos);
 
-std::vector<std::string> SplitIntoWords(const std::string&);
+//returns position of the space following the word which starts at pos or size of the text,
+//has_special_chars is set if the word contains special characters (codes from 0 to 31).
+//Both functions check 16 characters at once with SSE2 when it is available
+size_t FindWordEnd(std::string_view text, size_t pos, bool& has_special_chars);
+
+//a valid word must not contain special characters
+bool IsValidWord(std::string_view word);
+
+//lazy range of words of the text separated by spaces. Words are views into the text,
+//so the text must outlive the range and nothing is allocated while iterating.
+//Validity of every word is checked in the same pass which looks for its end
+class WordsRange {
+public:
+	class Iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::string_view*;
+		using reference = const std::string_view&;
+
+		Iterator(std::string_view text, size_t pos) : text_(text) {
+			MoveTo(pos);
+		}
+
+		reference operator*() const {
+			return word_;
+		}
+
+		pointer operator->() const {
+			return &word_;
+		}
+
+		Iterator& operator++() {
+			MoveTo(word_end_);
+			return *this;
+		}
+
+		//true if the current word contains special characters
+		bool HasSpecialChars() const {
+			return has_special_chars_;
+		}
+
+		bool operator==(const Iterator& other) const {
+			return word_.data() == other.word_.data() && word_.size() == other.word_.size();
+		}
+
+		bool operator!=(const Iterator& other) const {
+			return !(*this == other);
+		}
+
+	private:
+		std::string_view text_;
+		std::string_view word_;
+		size_t word_end_ = 0;
+		bool has_special_chars_ = false;
+
+		void MoveTo(size_t pos) {
+			const size_t word_begin = SkipSpaces(text_, pos);
+			has_special_chars_ = false;
+			word_end_ = FindWordEnd(text_, word_begin, has_special_chars_);
+			word_ = text_.substr(word_begin, word_end_ - word_begin);
+		}
+	};
+
+	explicit WordsRange(std::string_view text) : text_(text) {}
+
+	Iterator begin() const {
+		return Iterator(text_, 0);
+	}
+
+	Iterator end() const {
+		return Iterator(text_, text_.size());
+	}
+
+private:
+	std::string_view text_;
+};
+
+//returns views of all words of the text, they are valid while the text exists
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
 //returning set of string which creates from any container with .begin() and .end() methods
+//of strings or string views, set compares strings transparently, so it can be searched by string_view
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-	std::set<std::string> non_empty_strings;
-	for (const std::string& str : strings) {
-		if (!str.empty()) {
-			non_empty_strings.insert(str);
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+	std::set<std::string, std::less<>> non_empty_strings;
+	for (const auto& str : strings) {
+		if (!std::string_view(str).empty()) {
+			non_empty_strings.emplace(str);
 		};
 	};
 	return non_empty_strings;
@@ -0,0 +1,84 @@
+#include "term_dictionary.h"
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+	: terms_(other.terms_.size()), free_ids_(other.free_ids_) {
+	//views of the other dictionary point to its arena, so all words are stored again with the same ids
+	term_to_id_.reserve(other.term_to_id_.size());
+	for (TermId id = 0; id < other.terms_.size(); ++id) {
+		if (!other.terms_[id].empty()) {
+			terms_[id] = storage_.Store(other.terms_[id]);
+			term_to_id_.emplace(terms_[id], id);
+		};
+	};
+}
+
+TermDictionary::TermDictionary(const std::vector<std::string_view>& terms) : terms_(terms) {
+	term_to_id_.reserve(terms_.size());
+	for (TermId id = 0; id < terms_.size(); ++id) {
+		if (terms_[id].empty()) {
+			free_ids_.push_back(id);
+		}
+		else {
+			term_to_id_.emplace(terms_[id], id);
+		};
+	};
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+	if (this != &other) {
+		TermDictionary copy(other);
+		*this = std::move(copy);
+	};
+	return *this;
+}
+
+TermId TermDictionary::AddTerm(std::string_view term) {
+	const auto iter = term_to_id_.find(term);
+	if (iter != term_to_id_.end()) {
+		return iter->second;
+	};
+	const std::string_view stored = storage_.Store(term);
+	TermId id;
+	if (!free_ids_.empty()) {
+		id = free_ids_.back();
+		free_ids_.pop_back();
+		terms_[id] = stored;
+	}
+	else {
+		id = static_cast<TermId>(terms_.size());
+		terms_.push_back(stored);
+	};
+	term_to_id_.emplace(stored, id);
+	return id;
+}
+
+TermId TermDictionary::FindTerm(std::string_view term) const {
+	const auto iter = term_to_id_.find(term);
+	return iter == term_to_id_.end() ? NO_TERM : iter->second;
+}
+
+std::string_view TermDictionary::GetTerm(TermId id) const {
+	return terms_.at(id);
+}
+
+void TermDictionary::RemoveTerm(TermId id) {
+	if (terms_.at(id).empty()) {
+		return;
+	};
+	term_to_id_.erase(terms_[id]);
+	unused_bytes_ += terms_[id].size();
+	terms_[id] = {};
+	free_ids_.push_back(id);
+}
+
+void TermDictionary::Compact() {
+	*this = TermDictionary(*this); //copying stores only used words
+}
+
+size_t TermDictionary::GetUnusedBytes() const {
+	return unused_bytes_;
+}
+
+size_t TermDictionary::size() const {
+	return terms_.size();
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+
+using TermId = uint32_t;
+
+const TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+//this class stores every word only once and assigns it a dense integer id,
+//ids are given in order of adding starting from zero, so they can be used as indexes of vectors.
+//Bytes of words are kept in arena, views returned by GetTerm stay valid until Compact is called.
+//Ids of removed words are given to new words
+class TermDictionary {
+public:
+	TermDictionary() = default;
+
+	//dictionary of words kept in external memory (e.g. mapped snapshot file), bytes are not copied,
+	//so the memory must outlive the dictionary. Index of the view is id of the word, empty view is unused id
+	explicit TermDictionary(const std::vector<std::string_view>& terms);
+
+	TermDictionary(const TermDictionary&);
+
+	TermDictionary& operator=(const TermDictionary&);
+
+	TermDictionary(TermDictionary&&) = default;
+
+	TermDictionary& operator=(TermDictionary&&) = default;
+
+	//returns id of the word, adding it to the dictionary if it is new
+	TermId AddTerm(std::string_view);
+
+	//returns id of the word or NO_TERM if there is no such word in the dictionary
+	TermId FindTerm(std::string_view) const;
+
+	std::string_view GetTerm(TermId) const;
+
+	//removing word which is not used anymore, its bytes are freed only by Compact
+	void RemoveTerm(TermId);
+
+	//copying words which are still used into new arena and freeing the old one,
+	//views to words returned before become invalid, ids of words do not change
+	void Compact();
+
+	//amount of bytes of removed words which would be freed by Compact
+	size_t GetUnusedBytes() const;
+
+	//amount of given ids including ids of removed words, all ids are less than this number
+	size_t size() const;
+
+private:
+	Arena storage_;
+	std::vector<std::string_view> terms_; //view is empty if word was removed
+	std::vector<TermId> free_ids_;
+	std::unordered_map<std::string_view, TermId> term_to_id_;
+	size_t unused_bytes_ = 0;
+};
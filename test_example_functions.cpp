@@ -176,6 +176,950 @@ void RemoveDocumentTest() {
 	}
 }
 
+void PostingListTest() {
+	PostingList postings;
+	//ids are not growing, so most of them get into delta part
+	for (int id = 200; id > 0; id -= 2) {
+		postings.Add(id, id * 0.5);
+	}
+	postings.Remove(100);
+	postings.Remove(101); //there is no such posting, nothing should happen
+	postings.Add(101, 1.0);
+	ASSERT_EQUAL_HINT(postings.size(), 100u, "Wrong amount of postings"s);
+	ASSERT_HINT(!postings.Contains(100) && postings.Contains(101) && postings.Contains(2), "Wrong postings are found"s);
+
+	std::vector<int> ids;
+	postings.ForEach([&ids](int document_id, double term_freq) {
+		ASSERT_HINT(std::abs(term_freq - (document_id == 101 ? 1.0 : document_id * 0.5)) < 1e-6, "Wrong term frequency"s);
+		ids.push_back(document_id);
+		});
+	ASSERT_HINT(std::is_sorted(ids.begin(), ids.end()), "Postings must be sorted by document id"s);
+	postings.Merge();
+	std::vector<int> merged_ids;
+	postings.ForEach([&merged_ids](int document_id, double) { merged_ids.push_back(document_id); });
+	ASSERT_HINT(ids == merged_ids, "Merging must not change postings"s);
+}
+
+void ResultCountTest() {
+	SearchServer server;
+	for (int id = 0; id < 20; ++id) {
+		server.AddDocument(id, id % 2 ? "cat in the city"s : "cat and dog"s, DocumentStatus::ACTUAL, { id });
+	}
+	ASSERT_EQUAL_HINT(server.FindTopDocuments("cat"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT),
+		"Default amount of found documents must be MAX_RESULT_DOCUMENT_COUNT"s);
+
+	const auto found_docs = server.FindTopDocuments("cat city"s, DocumentStatus::ACTUAL, 12);
+	ASSERT_EQUAL_HINT(found_docs.size(), 12u, "Wrong amount of found documents for requested count"s);
+	ASSERT_HINT(std::is_sorted(found_docs.begin(), found_docs.end(), IsMoreRelevant), "Found documents must be sorted"s);
+	//all documents with "city" have the same relevance, so they are sorted by rating
+	ASSERT_EQUAL_HINT(found_docs[0].id, 19, "Wrong best document"s);
+
+	const auto found_docs_par = server.FindTopDocuments(std::execution::par, "cat city"s, DocumentStatus::ACTUAL, 12);
+	ASSERT_EQUAL_HINT(found_docs_par.size(), found_docs.size(), "Parallel version found wrong amount of documents"s);
+	for (size_t i = 0; i < found_docs.size(); ++i) {
+		ASSERT_EQUAL_HINT(found_docs_par[i].id, found_docs[i].id, "Parallel version found wrong documents"s);
+	}
+}
+
+void ParallelSearchTest() {
+	SearchServer server("and"s);
+	const std::vector<std::string> words = { "cat"s, "dog"s, "city"s, "house"s, "tail"s, "collar"s, "hat"s };
+	//enough documents to split slots into several parts
+	for (int id = 0; id < 20000; ++id) {
+		std::string text;
+		for (size_t i = 0; i < words.size(); ++i) {
+			if ((id + i) % (i + 2) == 0) {
+				text += words[i] + " and "s;
+			}
+		}
+		server.AddDocument(id, text + "bird"s, id % 3 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED, { id % 7 });
+	}
+	for (int id = 0; id < 20000; id += 5) {
+		server.RemoveDocument(id);
+	}
+
+	for (const std::string& query : { "cat dog"s, "city house -tail"s, "collar hat bird -cat"s }) {
+		const auto found_docs = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 50);
+		const auto found_docs_par = server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 50);
+		ASSERT_EQUAL_HINT(found_docs_par.size(), found_docs.size(), "Parallel version found wrong amount of documents"s);
+		for (size_t i = 0; i < found_docs.size(); ++i) {
+			ASSERT_EQUAL_HINT(found_docs_par[i].id, found_docs[i].id, "Parallel version found wrong documents"s);
+			ASSERT_HINT(std::abs(found_docs_par[i].relevance - found_docs[i].relevance) < 1e-6,
+				"Parallel version computed wrong relevance"s);
+		}
+	}
+}
+
+void ThreadPoolTest() {
+	{
+		ThreadPool pool(3);
+		std::atomic<int> sum = 0;
+		//nested calls must not deadlock, waiting threads execute tasks themselves
+		pool.ParallelFor(100, [&pool, &sum](size_t) {
+			pool.ParallelFor(10, [&sum](size_t index) { sum += static_cast<int>(index); });
+			});
+		ASSERT_EQUAL_HINT(sum.load(), 100 * 45, "Not all tasks were executed"s);
+
+		bool exception_thrown = false;
+		try {
+			pool.ParallelFor(10, [](size_t index) {
+				if (index == 7) {
+					throw std::runtime_error("error"s);
+				}
+				});
+		}
+		catch (const std::runtime_error&) {
+			exception_thrown = true;
+		}
+		ASSERT_HINT(exception_thrown, "Exception of task must be rethrown"s);
+	}
+	{
+		SearchServer server;
+		server.SetThreadPool(std::make_shared<ThreadPool>(2));
+		server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1 });
+		server.AddDocument(2, "dog in the house"s, DocumentStatus::ACTUAL, { 2 });
+		ASSERT_EQUAL_HINT(server.GetThreadPool().GetWorkerCount(), 2u, "Server must use pool set by SetThreadPool"s);
+		const auto found_docs = server.FindTopDocuments(std::execution::par, "cat"s);
+		ASSERT_EQUAL_HINT(found_docs.size(), 1u, "Server with own pool found wrong amount of documents"s);
+	}
+}
+
+void TokenizerTest() {
+	//words and spaces are longer than one SIMD block to check both paths of scanning
+	const std::string text = "  short                    verylongwordwithoutanyspaces пушистый   end"s;
+	const std::vector<std::string_view> expected = { "short"sv, "verylongwordwithoutanyspaces"sv, "пушистый"sv, "end"sv };
+	ASSERT_HINT(SplitIntoWords(text) == expected, "Text is split into wrong words"s);
+	ASSERT_HINT(SplitIntoWords("    "s).empty(), "Text of spaces has no words"s);
+
+	ASSERT_HINT(IsValidWord("пушистый"s), "UTF-8 characters are not special"s);
+	ASSERT_HINT(!IsValidWord("abcdefghijklmnopqrst\x12u"s), "Special character after the first block was not found"s);
+
+	const std::string text_with_special_char = "valid abcdefghijklmnopqrstuv\x01w valid"s;
+	std::vector<bool> special_chars;
+	const WordsRange words(text_with_special_char);
+	for (auto iter = words.begin(); iter != words.end(); ++iter) {
+		special_chars.push_back(iter.HasSpecialChars());
+	}
+	ASSERT_HINT(special_chars == std::vector<bool>({ false, true, false }), "Special characters are found in wrong words"s);
+}
+
+void TermStorageCompactionTest() {
+	SearchServer server;
+	server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1 });
+	server.AddDocument(2, "dog in the house"s, DocumentStatus::ACTUAL, { 2 });
+	server.RemoveDocument(2);
+	//"dog" and "house" are not used anymore, "in" and "the" are still used by document 1
+	ASSERT_EQUAL_HINT(server.GetUnusedTermBytes(), 8u, "Wrong amount of unused bytes of words"s);
+	server.CompactTermStorage();
+	ASSERT_EQUAL_HINT(server.GetUnusedTermBytes(), 0u, "Compaction must free unused bytes"s);
+
+	//ids of removed words are reused by new words
+	server.AddDocument(3, "bird in the sky"s, DocumentStatus::ACTUAL, { 3 });
+	ASSERT_HINT(server.FindTopDocuments("dog house"s).empty(), "Removed words must not be found"s);
+	const auto found_docs = server.FindTopDocuments("bird city"s);
+	ASSERT_EQUAL_HINT(found_docs.size(), 2u, "Wrong amount of documents found after compaction"s);
+	const auto words = server.GetWordFrequencies(1);
+	ASSERT_HINT(words.count("city"sv) && words.count("cat"sv), "Words of document must be kept by compaction"s);
+}
+
+void AddDocumentsTest() {
+	const std::vector<std::string> texts = { "white cat and fancy collar"s, "fluffy cat fluffy tail"s, "groomed dog expressive eyes"s };
+	std::vector<DocumentInput> documents;
+	SearchServer single_server("and"s);
+	for (int id = 0; id < 300; ++id) {
+		const std::string& text = texts[id % texts.size()];
+		documents.push_back({ id, text, DocumentStatus::ACTUAL, { id % 7, 1 } });
+		single_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 7, 1 });
+	};
+	SearchServer batch_server("and"s);
+	batch_server.AddDocuments(documents);
+	ASSERT_EQUAL_HINT(batch_server.GetDocumentCount(), 300, "All documents of the batch must be added"s);
+	for (const std::string& query : { "fluffy cat"s, "dog -eyes"s, "fancy groomed tail"s }) {
+		const auto expected = single_server.FindTopDocuments(query);
+		const auto found = batch_server.FindTopDocuments(query);
+		ASSERT_EQUAL_HINT(found.size(), expected.size(), "Batch and single adding must give the same results"s);
+		for (size_t i = 0; i < found.size(); ++i) {
+			ASSERT_HINT(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance
+				&& found[i].rating == expected[i].rating, "Batch and single adding must give the same results"s);
+		};
+	};
+
+	//invalid document anywhere in the batch cancels adding of the whole batch
+	const std::string invalid_text = "bad\x12word"s;
+	std::vector<std::vector<DocumentInput>> invalid_batches = {
+		{ { 1000, texts[0], DocumentStatus::ACTUAL, {} }, { 5, texts[1], DocumentStatus::ACTUAL, {} } },
+		{ { 1000, texts[0], DocumentStatus::ACTUAL, {} }, { 1000, texts[1], DocumentStatus::ACTUAL, {} } },
+		{ { 1000, texts[0], DocumentStatus::ACTUAL, {} }, { 1001, invalid_text, DocumentStatus::ACTUAL, {} } },
+	};
+	for (const auto& batch : invalid_batches) {
+		bool thrown = false;
+		try {
+			batch_server.AddDocuments(batch);
+		}
+		catch (const std::invalid_argument&) {
+			thrown = true;
+		};
+		ASSERT_HINT(thrown, "Invalid batch must throw invalid_argument"s);
+		ASSERT_EQUAL_HINT(batch_server.GetDocumentCount(), 300, "Invalid batch must not add any documents"s);
+	};
+}
+
+void SnapshotTest() {
+	const std::string path = (std::filesystem::temp_directory_path() / "search_server_snapshot_test.bin"s).string();
+	SearchServer server("and with"s);
+	server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+	server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+	server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+	server.AddDocument(4, "groomed starling eugene"s, DocumentStatus::ACTUAL, { 9 });
+	server.RemoveDocument(4);
+	server.SaveSnapshot(path);
+
+	SearchServer opened = SearchServer::OpenSnapshot(path);
+	const auto check_same = [](const SearchServer& expected, const SearchServer& actual) {
+		ASSERT_EQUAL_HINT(actual.GetDocumentCount(), expected.GetDocumentCount(), "Wrong amount of documents in snapshot"s);
+		for (const std::string& query : { "fluffy groomed cat"s, "cat -collar"s, "and eugene"s, "parrot"s }) {
+			for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+				const auto expected_docs = expected.FindTopDocuments(query, status);
+				const auto actual_docs = actual.FindTopDocuments(query, status);
+				ASSERT_EQUAL_HINT(actual_docs.size(), expected_docs.size(), "Snapshot must give the same results"s);
+				for (size_t i = 0; i < actual_docs.size(); ++i) {
+					ASSERT_HINT(actual_docs[i].id == expected_docs[i].id && actual_docs[i].relevance == expected_docs[i].relevance
+						&& actual_docs[i].rating == expected_docs[i].rating, "Snapshot must give the same results"s);
+				};
+			};
+		};
+		for (const int document_id : expected) {
+			ASSERT_HINT(actual.GetWordFrequencies(document_id) == expected.GetWordFrequencies(document_id),
+				"Snapshot must keep words of documents"s);
+			ASSERT_HINT(actual.MatchDocument(std::execution::par, "cat tail -eyes"s, document_id)
+				== expected.MatchDocument(std::execution::par, "cat tail -eyes"s, document_id), "Snapshot must keep words of documents"s);
+		};
+	};
+	check_same(server, opened);
+
+	//opened server can be changed as usual, changes do not touch the file
+	for (SearchServer* changed : { &server, &opened }) {
+		changed->AddDocument(5, "fluffy parrot with long tail"s, DocumentStatus::ACTUAL, { 3 });
+		changed->RemoveDocument(std::execution::par, 1);
+		changed->RemoveDocument(2);
+	};
+	check_same(server, opened);
+	opened.SaveSnapshot(path);
+	check_same(server, SearchServer::OpenSnapshot(path));
+
+	{
+		std::ofstream damaged(path, std::ios::binary | std::ios::trunc);
+		damaged << "not a snapshot"s;
+	}
+	bool thrown = false;
+	try {
+		SearchServer::OpenSnapshot(path);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	};
+	ASSERT_HINT(thrown, "Opening damaged snapshot must throw runtime_error"s);
+
+	//snapshots of servers which differ only in one value show its position, the value is damaged there
+	const auto read_file = [](const std::string& file_path) {
+		std::ifstream input(file_path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+	};
+	const auto check_damaged_value = [&](SearchServer& original, SearchServer& changed, const std::string& hint) {
+		original.SaveSnapshot(path);
+		const std::string original_bytes = read_file(path);
+		changed.SaveSnapshot(path);
+		std::string bytes = read_file(path);
+		ASSERT_HINT(bytes.size() == original_bytes.size(), hint);
+		const size_t position = std::mismatch(bytes.begin(), bytes.end(), original_bytes.begin()).first - bytes.begin();
+		ASSERT_HINT(position < bytes.size(), hint);
+		bytes[position] = static_cast<char>(0x7F);
+		{
+			std::ofstream damaged(path, std::ios::binary | std::ios::trunc);
+			damaged << bytes;
+		}
+		bool is_damage_found = false;
+		try {
+			SearchServer::OpenSnapshot(path);
+		}
+		catch (const std::runtime_error&) {
+			is_damage_found = true;
+		};
+		ASSERT_HINT(is_damage_found, hint);
+	};
+	{
+		SearchServer actual_server, banned_server;
+		actual_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+		banned_server.AddDocument(1, "white cat"s, DocumentStatus::BANNED, { 1 });
+		check_damaged_value(actual_server, banned_server, "Unknown status in snapshot must throw runtime_error"s);
+	}
+	{
+		//postings of "dog" differ only in slot
+		SearchServer first_server, second_server;
+		first_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, { 1 });
+		first_server.AddDocument(2, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+		second_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+		second_server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, { 1 });
+		check_damaged_value(first_server, second_server, "Posting slot out of range in snapshot must throw runtime_error"s);
+	}
+	std::filesystem::remove(path);
+}
+
+void CompressedPostingsTest() {
+	//packing of every bit width must keep values
+	for (unsigned bit_width = 0; bit_width <= 32; ++bit_width) {
+		uint32_t values[PACKED_BLOCK_SIZE];
+		for (size_t i = 0; i < PACKED_BLOCK_SIZE; ++i) {
+			values[i] = static_cast<uint32_t>(i * 2654435761u) & (bit_width == 32 ? ~0u : (1u << bit_width) - 1);
+		}
+		uint32_t packed[PACKED_BLOCK_SIZE] = {};
+		uint32_t unpacked[PACKED_BLOCK_SIZE] = {};
+		PackBlock(values, bit_width, packed);
+		UnpackBlock(packed, bit_width, unpacked);
+		ASSERT_HINT(std::equal(values, values + PACKED_BLOCK_SIZE, unpacked), "Unpacked values differ from packed ones"s);
+	}
+
+	PostingList postings;
+	PostingList compressed;
+	for (DocumentSlot slot = 0; slot < 1000; slot += 1 + slot % 7) {
+		postings.Add(slot, 1.0 / (1 + slot % 5));
+		compressed.Add(slot, 1.0 / (1 + slot % 5));
+	}
+	compressed.Compress();
+	ASSERT_HINT(compressed.IsCompressed(), "List must be compressed"s);
+	const auto check_same = [&postings, &compressed](DocumentSlot begin_slot, DocumentSlot end_slot) {
+		std::vector<std::pair<DocumentSlot, double>> expected;
+		std::vector<std::pair<DocumentSlot, double>> actual;
+		postings.ForEachInRange(begin_slot, end_slot, [&expected](DocumentSlot slot, double freq) { expected.push_back({ slot, freq }); });
+		compressed.ForEachInRange(begin_slot, end_slot, [&actual](DocumentSlot slot, double freq) { actual.push_back({ slot, freq }); });
+		ASSERT_HINT(actual == expected, "Compressed list must keep postings exactly"s);
+	};
+	check_same(0, NO_SLOT);
+	check_same(300, 700);
+
+	//changes of compressed list go to delta part and are compressed again when merged
+	for (DocumentSlot slot = 3; slot < 900; slot += 40) {
+		postings.Remove(slot);
+		compressed.Remove(slot);
+	}
+	postings.Add(2000, 0.25);
+	compressed.Add(2000, 0.25);
+	check_same(0, NO_SLOT);
+	ASSERT_EQUAL_HINT(compressed.size(), postings.size(), "Wrong amount of postings in compressed list"s);
+	ASSERT_HINT(compressed.Contains(2000) && !compressed.Contains(3) && compressed.Contains(7), "Wrong postings are found"s);
+	compressed.Merge();
+	ASSERT_HINT(compressed.IsCompressed(), "Merged list must stay compressed"s);
+	check_same(0, NO_SLOT);
+	ASSERT_HINT(compressed.GetMemoryUsage() * 4 < postings.GetMemoryUsage(), "Compressed list must take less memory"s);
+
+	SearchServer server("and with"s);
+	for (int id = 0; id < 2000; ++id) {
+		server.AddDocument(id, id % 3 ? "fluffy cat with fluffy tail"s : "groomed dog and fancy collar"s, DocumentStatus::ACTUAL, { id % 11 });
+	}
+	const auto expected = server.FindTopDocuments("fluffy collar -dog"s, DocumentStatus::ACTUAL, 20);
+	server.CompressPostings();
+	const auto found = server.FindTopDocuments(std::execution::par, "fluffy collar -dog"s, DocumentStatus::ACTUAL, 20);
+	ASSERT_EQUAL_HINT(found.size(), expected.size(), "Compression must not change search results"s);
+	for (size_t i = 0; i < found.size(); ++i) {
+		ASSERT_HINT(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance,
+			"Compression must not change search results"s);
+	}
+}
+
+void InverseDocumentFreqCacheTest() {
+	SearchServer server;
+	server.AddDocument(1, "cat city"s, DocumentStatus::ACTUAL, { 1 });
+	server.AddDocument(2, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+	server.AddDocuments({ { 3, "dog house"sv, DocumentStatus::ACTUAL, { 1 } }, { 4, "bird sky"sv, DocumentStatus::ACTUAL, { 1 } } });
+	server.RemoveDocument(std::execution::par, 4);
+	server.RemoveDocument(2);
+	//cached frequencies must follow all changes: 2 documents are left, "cat" is in one of them
+	const auto found_docs = server.FindTopDocuments("cat"s);
+	ASSERT_EQUAL_HINT(found_docs.size(), 1u, "Wrong amount of found documents"s);
+	ASSERT_HINT(std::abs(found_docs[0].relevance - 0.5 * std::log(2.0)) < 1e-12, "Wrong relevance with cached frequencies"s);
+
+	server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, { 1 });
+	for (const Document& document : server.FindTopDocuments("cat"s)) {
+		const double term_freq = document.id == 5 ? 1.0 : 0.5;
+		ASSERT_HINT(std::abs(document.relevance - term_freq * std::log(3.0 / 2.0)) < 1e-12, "Wrong relevance with cached frequencies"s);
+	}
+}
+
+void MaxScoreTest() {
+	SearchServer server("and"s);
+	const std::vector<std::string> words = { "cat"s, "dog"s, "parrot"s, "tail"s, "collar"s, "eyes"s, "fluffy"s, "groomed"s };
+	for (int id = 0; id < 3000; ++id) {
+		//"the" is in every document, other words are more rare
+		std::string text = "the"s;
+		for (int i = 0; i < 1 + id % 4; ++i) {
+			text += " "s + words[(id * 7 + i * 3 + id / 5) % words.size()];
+		}
+		server.AddDocument(id, text, id % 5 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED, { id % 13 });
+	}
+	for (int id = 0; id < 3000; id += 17) {
+		server.RemoveDocument(id);
+	}
+
+	//pruned search of the best documents must give the beginning of full ranking where nothing can be pruned
+	const auto check_same = [&server](const std::string& query) {
+		const auto predicate = [](int document_id, DocumentStatus, int) { return document_id % 3 != 0; };
+		const auto all_docs = server.FindTopDocuments(query, predicate, 100000);
+		for (const size_t count : { 1u, 5u, 50u }) {
+			const auto found_docs = server.FindTopDocuments(query, predicate, count);
+			const auto found_docs_par = server.FindTopDocuments(std::execution::par, query, predicate, count);
+			ASSERT_EQUAL_HINT(found_docs.size(), std::min(count, all_docs.size()), "Wrong amount of found documents"s);
+			ASSERT_EQUAL_HINT(found_docs_par.size(), found_docs.size(), "Wrong amount of found documents"s);
+			for (size_t i = 0; i < found_docs.size(); ++i) {
+				ASSERT_HINT(found_docs[i].id == all_docs[i].id && found_docs[i].relevance == all_docs[i].relevance
+					&& found_docs_par[i].id == all_docs[i].id, "MaxScore must give the same results as full scoring"s);
+			}
+		}
+	};
+	for (const std::string& query : { "the parrot"s, "the cat collar -eyes"s, "fluffy groomed tail the"s }) {
+		check_same(query);
+	}
+	server.CompressPostings();
+	check_same("the cat collar -eyes"s);
+}
+
+void QueryCacheTest() {
+	SearchServer server("and"s);
+	server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8 });
+	server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7 });
+	server.SetQueryCacheCapacity(2);
+
+	const auto get_ids = [](const std::vector<Document>& documents) {
+		std::vector<int> ids;
+		for (const Document& document : documents) {
+			ids.push_back(document.id);
+		}
+		return ids;
+	};
+	const auto found_ids = get_ids(server.FindTopDocuments("cat collar"s));
+	//the same normalized query is found in cache, parallel version uses the same cache
+	ASSERT_HINT(get_ids(server.FindTopDocuments("collar and cat cat"s)) == found_ids, "Cached results differ"s);
+	ASSERT_HINT(get_ids(server.FindTopDocuments(std::execution::par, "collar cat"s)) == found_ids, "Cached results differ"s);
+	QueryCacheStats stats = server.GetQueryCacheStats();
+	ASSERT_HINT(stats.hits == 2 && stats.misses == 1 && stats.size == 1, "Wrong statistics of query cache"s);
+
+	//other status, predicate type or amount of documents are different queries,
+	//predicates with state are not cached at all
+	server.FindTopDocuments("cat collar"s, DocumentStatus::BANNED);
+	server.FindTopDocuments("cat collar"s, [](int, DocumentStatus, int rating) { return rating > 7; });
+	const int min_rating = 7;
+	server.FindTopDocuments("cat collar"s, [min_rating](int, DocumentStatus, int rating) { return rating > min_rating; });
+	stats = server.GetQueryCacheStats();
+	ASSERT_HINT(stats.hits == 2 && stats.misses == 3 && stats.size == 2, "Wrong statistics of query cache"s);
+
+	//changing the index drops cached results
+	const uint64_t index_version = server.GetIndexVersion();
+	server.AddDocument(3, "cat with collar"s, DocumentStatus::ACTUAL, { 1 });
+	ASSERT_HINT(server.GetIndexVersion() != index_version, "Adding must change version of the index"s);
+	const auto new_found_docs = server.FindTopDocuments("cat collar"s);
+	ASSERT_EQUAL_HINT(new_found_docs.size(), 3u, "Results must be found again after index change"s);
+	stats = server.GetQueryCacheStats();
+	ASSERT_HINT(stats.hits == 2 && stats.misses == 4 && stats.size == 1, "Wrong statistics of query cache"s);
+}
+
+void ConcurrentSearchServerTest() {
+	ConcurrentSearchServer server(SearchServer("and"s));
+	server.AddDocument(0, "common word"s, DocumentStatus::ACTUAL, { 1 });
+
+	//every document has word "common", so in every consistent snapshot all documents are found by it
+	std::atomic<bool> is_writing = true;
+	std::atomic<int> inconsistent_snapshots = 0;
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 3; ++i) {
+		readers.emplace_back([&server, &is_writing, &inconsistent_snapshots] {
+			while (is_writing) {
+				const auto snapshot = server.GetSnapshot();
+				const auto found_docs = snapshot->FindTopDocuments("common"s, DocumentStatus::ACTUAL, 1000);
+				if (static_cast<int>(found_docs.size()) != snapshot->GetDocumentCount()) {
+					++inconsistent_snapshots;
+				}
+			}
+			});
+	}
+	for (int id = 1; id < 300; ++id) {
+		server.AddDocument(id, "common word number "s + std::to_string(id), DocumentStatus::ACTUAL, { id });
+		if (id % 3 == 0) {
+			server.RemoveDocument(id - 1);
+		}
+	}
+	bool thrown = false;
+	try {
+		server.AddDocument(1, "duplicate id"s, DocumentStatus::ACTUAL, {});
+	}
+	catch (const std::invalid_argument&) {
+		thrown = true;
+	}
+	is_writing = false;
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+	ASSERT_HINT(thrown, "Invalid document must throw invalid_argument"s);
+	ASSERT_EQUAL_HINT(inconsistent_snapshots.load(), 0, "Readers must see only complete changes"s);
+	ASSERT_EQUAL_HINT(server.GetSnapshot()->GetDocumentCount(), 201, "Wrong amount of documents after all changes"s);
+
+	//writer holding snapshot must not wait for itself, snapshot keeps the old version
+	const auto held_snapshot = server.GetSnapshot();
+	server.AddDocument(1000, "common held"s, DocumentStatus::ACTUAL, { 1 });
+	server.RemoveDocument(1000);
+	server.AddDocument(1001, "common held"s, DocumentStatus::ACTUAL, { 1 });
+	ASSERT_EQUAL_HINT(held_snapshot->GetDocumentCount(), 201, "Held snapshot must not be changed"s);
+	ASSERT_HINT(held_snapshot->FindTopDocuments("held"s).empty(), "Held snapshot must not see new documents"s);
+	const auto new_snapshot = server.GetSnapshot();
+	ASSERT_EQUAL_HINT(new_snapshot->GetDocumentCount(), 202, "Changes must be published while snapshot is held"s);
+	ASSERT_HINT(new_snapshot->FindTopDocuments("held"s).size() == 1 && new_snapshot->FindTopDocuments("held"s)[0].id == 1001,
+		"Changes applied to copy of published index are lost"s);
+}
+
+void SegmentedIndexTest() {
+	//appended postings are sealed into segments, trailing segments of the same tier are merged
+	const size_t posting_count = PostingList::TAIL_SIZE * PostingList::MERGE_FACTOR * 3 + 100;
+	PostingList postings;
+	for (DocumentSlot slot = 0; slot < posting_count; ++slot) {
+		postings.Add(slot * 2, 1.0 / (1 + slot % 5));
+		if (postings.IsTailFull()) {
+			postings.SealTail();
+		}
+	}
+	ASSERT_EQUAL_HINT(postings.size(), posting_count, "Sealing must keep all postings"s);
+	ASSERT_HINT(postings.GetSegmentCount() < PostingList::MERGE_FACTOR * 2, "Segments of the same tier must be merged"s);
+	DocumentSlot expected_slot = 0;
+	bool is_ordered = true;
+	postings.ForEach([&expected_slot, &is_ordered](DocumentSlot slot, double term_freq) {
+		is_ordered = is_ordered && slot == expected_slot * 2 && term_freq == 1.0 / (1 + expected_slot % 5);
+		++expected_slot;
+		});
+	ASSERT_HINT(is_ordered && expected_slot == posting_count, "Segments must be scanned in order of slots"s);
+	PostingList::Cursor cursor(postings);
+	for (const DocumentSlot slot : { 7u, 8200u, 8201u, 60001u }) {
+		cursor.SeekTo(slot);
+		ASSERT_EQUAL_HINT(cursor.GetSlot(), (slot + 1) / 2 * 2, "Cursor must jump over segments"s);
+	}
+	postings.Merge([](DocumentSlot slot) { return slot % 4 == 0; });
+	ASSERT_EQUAL_HINT(postings.GetSegmentCount(), 1u, "Merging must give one segment"s);
+	ASSERT_EQUAL_HINT(postings.size(), posting_count / 2, "Merging must drop postings of removed documents"s);
+
+	//removed documents stay in segments until merging, but they are never found
+	SearchServer server("and"s);
+	SearchServer expected_server("and"s);
+	const std::vector<std::string> words = { "cat"s, "dog"s, "parrot"s, "tail"s, "collar"s };
+	const int document_count = static_cast<int>(PostingList::TAIL_SIZE) * 3;
+	for (int id = 0; id < document_count; ++id) {
+		const std::string text = "the "s + words[id % words.size()] + " "s + words[id / 7 % words.size()];
+		server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 11 });
+		if (id % 3 != 0) {
+			expected_server.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 11 });
+		}
+	}
+	for (int id = 0; id < document_count; id += 3) {
+		server.RemoveDocument(id);
+	}
+	const auto check_same = [&server, &expected_server]() {
+		for (const std::string& query : { "the"s, "cat"s, "the parrot -tail"s, "dog collar"s }) {
+			const auto found_docs = server.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+			const auto found_docs_par = server.FindTopDocuments(std::execution::par, query, DocumentStatus::ACTUAL, 20);
+			const auto expected_docs = expected_server.FindTopDocuments(query, DocumentStatus::ACTUAL, 20);
+			ASSERT_EQUAL_HINT(found_docs.size(), expected_docs.size(), "Removed documents must not be found"s);
+			ASSERT_EQUAL_HINT(found_docs_par.size(), expected_docs.size(), "Removed documents must not be found"s);
+			for (size_t i = 0; i < found_docs.size(); ++i) {
+				ASSERT_HINT(found_docs[i].id == expected_docs[i].id && found_docs[i].relevance == expected_docs[i].relevance
+					&& found_docs_par[i].id == expected_docs[i].id, "Removed documents must not change results"s);
+			}
+		}
+	};
+	check_same();
+	const size_t bytes_before_merging = server.GetPostingBytes();
+	server.MergeSegments();
+	ASSERT_HINT(server.GetPostingBytes() < bytes_before_merging, "Merging must drop postings of removed documents"s);
+	check_same();
+	server.CompressPostings();
+	expected_server.CompressPostings();
+	for (int id = document_count; id < document_count + 100; ++id) {
+		server.AddDocument(id, "the cat"s, DocumentStatus::ACTUAL, { 1 });
+		expected_server.AddDocument(id, "the cat"s, DocumentStatus::ACTUAL, { 1 });
+	}
+	check_same();
+}
+
+void CorpusGeneratorTest() {
+	CorpusOptions options;
+	options.document_count = 500;
+	options.query_count = 50;
+	options.duplicate_ratio = 0.2;
+	const Corpus corpus = GenerateCorpus(options);
+	const Corpus same_corpus = GenerateCorpus(options);
+	ASSERT_EQUAL_HINT(corpus.documents.size(), 500u, "Wrong amount of generated documents"s);
+	ASSERT_EQUAL_HINT(corpus.queries.size(), 50u, "Wrong amount of generated queries"s);
+	ASSERT_HINT(corpus.documents == same_corpus.documents && corpus.queries == same_corpus.queries
+		&& corpus.ratings == same_corpus.ratings, "The same options must give the same corpus"s);
+	options.seed = 2;
+	ASSERT_HINT(GenerateCorpus(options).documents != corpus.documents, "Another seed must give another corpus"s);
+
+	//generated texts are valid documents and queries
+	SearchServer server(corpus.stop_words);
+	for (size_t id = 0; id < corpus.documents.size(); ++id) {
+		server.AddDocument(static_cast<int>(id), corpus.documents[id], corpus.statuses[id], corpus.ratings[id]);
+	}
+	for (const std::string& query : corpus.queries) {
+		server.FindTopDocuments(query);
+	}
+
+	const BenchmarkOptions benchmark_options = ParseBenchmarkOptions({ "--documents=1000"s, "--zipf=1.2"s, "--format=csv"s });
+	ASSERT_EQUAL_HINT(benchmark_options.corpus.document_count, 1000u, "Option must be parsed"s);
+	ASSERT_HINT(benchmark_options.corpus.zipf_exponent == 1.2 && benchmark_options.format == BenchmarkFormat::CSV,
+		"Options must be parsed"s);
+	for (const std::string& bad_option : { "--documents=many"s, "--unknown=1"s, "documents=1"s, "--format=xml"s }) {
+		bool thrown = false;
+		try {
+			ParseBenchmarkOptions({ bad_option });
+		}
+		catch (const std::invalid_argument&) {
+			thrown = true;
+		}
+		ASSERT_HINT(thrown, "Bad option must throw invalid_argument"s);
+	}
+}
+
+void SearchMetricsTest() {
+	//every duration is not bigger than upper bound of its bucket and is bigger than upper bound of the previous one
+	for (const uint64_t nanoseconds : { 0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 100ull, 1000ull, 123456789ull }) {
+		const size_t bucket = LatencyHistogram::GetBucket(nanoseconds);
+		ASSERT_HINT(nanoseconds <= LatencyHistogram::GetBucketUpperBound(bucket)
+			&& (bucket == 0 || nanoseconds > LatencyHistogram::GetBucketUpperBound(bucket - 1)), "Wrong bucket of duration"s);
+	}
+	LatencyHistogram histogram;
+	for (size_t bucket = 0; bucket < 100; ++bucket) {
+		histogram.Add(bucket, 1, 10);
+	}
+	ASSERT_EQUAL_HINT(histogram.GetCount(), 100u, "Wrong amount of durations"s);
+	ASSERT_EQUAL_HINT(histogram.GetPercentileNanoseconds(0.5), LatencyHistogram::GetBucketUpperBound(49), "Wrong median"s);
+
+	//shards of exited threads are given to new threads with their values, so amount of shards does not grow
+	for (int i = 0; i < 3; ++i) {
+		SearchMetrics thread_metrics;
+		for (int j = 0; j < 10; ++j) {
+			std::thread([&thread_metrics] { thread_metrics.Count(SearchCounter::QUERIES, 1); }).join();
+		}
+		//this thread takes the shard of the last exited one. Slot of destroyed metrics is reused,
+		//shard which this thread had there must not be taken
+		thread_metrics.Count(SearchCounter::QUERIES, 5);
+		ASSERT_EQUAL_HINT(thread_metrics.GetShardCount(), 1u, "Shards of exited threads must be reused"s);
+		ASSERT_EQUAL_HINT(thread_metrics.GetSnapshot().GetCounter(SearchCounter::QUERIES), 15u,
+			"Records of exited threads must be kept"s);
+	}
+
+	SearchServer server("and"s);
+	server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8 });
+	server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7 });
+	server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5 });
+	server.FindTopDocuments("cat -collar"s);
+	server.FindTopDocuments(std::execution::par, "fluffy dog"s);
+	server.FindTopDocuments("cat tail"s, [](int document_id, DocumentStatus, int) { return document_id > 1; });
+	const SearchMetricsSnapshot metrics = server.GetMetrics();
+#ifdef SEARCH_SERVER_METRICS_ENABLED
+	ASSERT_EQUAL_HINT(metrics.GetCounter(SearchCounter::QUERIES), 3u, "Every query must be counted"s);
+	ASSERT_EQUAL_HINT(metrics.GetStage(SearchStage::QUERY).GetCount(), 3u, "Every query must be measured"s);
+	ASSERT_EQUAL_HINT(metrics.GetStage(SearchStage::PARSE).GetCount(), 3u, "Every parsing must be measured"s);
+	//documents 2, then 2 and 3, then 2 (document 1 is dropped by predicate) are scored
+	ASSERT_HINT(metrics.GetCounter(SearchCounter::POSTINGS_SCANNED) >= 3, "Scanned postings must be counted"s);
+	ASSERT_EQUAL_HINT(metrics.GetCounter(SearchCounter::CANDIDATES_SCORED), 4u, "Scored documents must be counted"s);
+	std::ostringstream output;
+	ExportSearchMetrics(output, metrics);
+	ASSERT_HINT(output.str().find("search_queries_total 3\n"s) != std::string::npos, "Counters must be exported"s);
+	ASSERT_HINT(output.str().find("search_stage_seconds_count{stage=\"parse\"} 3\n"s) != std::string::npos,
+		"Stages must be exported"s);
+	server.ResetMetrics();
+	ASSERT_EQUAL_HINT(server.GetMetrics().GetCounter(SearchCounter::QUERIES), 0u, "Metrics must be reset"s);
+
+	//every thread writes into its own shard, records of exited threads are kept
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 20; ++i) {
+		threads.emplace_back([&server] { server.FindTopDocuments("cat"s); });
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	ASSERT_EQUAL_HINT(server.GetMetrics().GetCounter(SearchCounter::QUERIES), 20u, "Queries of all threads must be counted"s);
+#else
+	ASSERT_EQUAL_HINT(metrics.GetCounter(SearchCounter::QUERIES), 0u, "Disabled metrics must be empty"s);
+#endif
+}
+
+void RequestQueueTest() {
+	SearchServer server("and"s);
+	server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8 });
+	server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7 });
+	auto now = std::chrono::steady_clock::time_point();
+	RequestQueue request_queue(server, [&now] { return now; }, 2);
+	ASSERT_EQUAL_HINT(request_queue.GetNoResultRate(), 0.0, "Rate without requests must be 0"s);
+
+	//many requests in one minute are kept in one bucket
+	for (int i = 0; i < 3; ++i) {
+		request_queue.AddFindRequest("dog"s);
+	}
+	request_queue.AddFindRequest("cat"s);
+	now += std::chrono::hours(12);
+	request_queue.AddFindRequest("parrot"s);
+	request_queue.AddFindRequests({ "cat"s, "dog"s, "bird"s });
+	ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 8, "Every request must be counted"s);
+	ASSERT_EQUAL_HINT(request_queue.GetNoResultRequests(), 6, "Every empty request must be counted"s);
+	ASSERT_EQUAL_HINT(request_queue.GetNoResultRate(), 6.0 / 8, "Wrong rate of empty requests"s);
+
+	//requests of the first minute leave the window after a day
+	now += std::chrono::hours(12);
+	ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 4, "Old requests must leave the window"s);
+	ASSERT_EQUAL_HINT(request_queue.GetNoResultRequests(), 3, "Old empty requests must leave the window"s);
+	now += std::chrono::hours(24);
+	ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 0, "All requests must leave the window"s);
+	request_queue.AddFindRequest("cat"s);
+	ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 1, "Reused bucket must start from zero"s);
+
+	//request with time already behind the window is not counted
+	now -= std::chrono::hours(25);
+	request_queue.AddFindRequest("cat"s);
+	now += std::chrono::hours(25);
+	ASSERT_EQUAL_HINT(request_queue.GetRequestCount(), 1, "Request older than the window must not be counted"s);
+	ASSERT_EQUAL_HINT(request_queue.GetNoResultRate(), 0.0, "Wrong rate after window moved"s);
+
+	//"dog" was seen 4 times, "bird" took place of "parrot" and inherited its count as error
+	const auto top_queries = request_queue.GetTopNoResultQueries(5);
+	ASSERT_EQUAL_HINT(top_queries.size(), 2u, "Sketch must keep its capacity"s);
+	ASSERT_HINT(top_queries[0].query == "dog"s && top_queries[0].count == 4 && top_queries[0].error == 0,
+		"Frequent query must be counted exactly"s);
+	ASSERT_HINT(top_queries[1].query == "bird"s && top_queries[1].count == 2 && top_queries[1].error == 1,
+		"New query must inherit count of replaced one as error"s);
+}
+
+void RemoveDuplicatesTest() {
+	SearchServer server("and with"s);
+	server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7 });
+	server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1 });
+	//order, repeats and stop words do not matter
+	server.AddDocument(3, "nasty rat funny pet funny"s, DocumentStatus::ACTUAL, { 2 });
+	server.AddDocument(4, "curly hair funny pet"s, DocumentStatus::BANNED, { 3 });
+	server.AddDocument(5, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, { 4 });
+	server.AddDocument(6, "pet and rat"s, DocumentStatus::ACTUAL, { 5 });
+	server.AddDocument(7, "rat and pet"s, DocumentStatus::ACTUAL, { 6 });
+	std::ostringstream output;
+	std::streambuf* const cout_buffer = std::cout.rdbuf(output.rdbuf());
+	RemoveDuplicates(server);
+	std::cout.rdbuf(cout_buffer);
+	ASSERT_EQUAL_HINT(output.str(), "Found duplicate document id 3\nFound duplicate document id 4\nFound duplicate document id 7\n"s,
+		"Later duplicates must be removed in order of ids"s);
+	ASSERT_EQUAL_HINT(server.GetDocumentCount(), 4, "Duplicates must be removed"s);
+	ASSERT_EQUAL_HINT(server.FindTopDocuments("hair"s).size(), 1u, "The first document must be kept"s);
+
+	//word of several removed documents is removed once and can be added again
+	server.RemoveDocuments({ 2, 5, 100 });
+	ASSERT_EQUAL_HINT(server.GetDocumentCount(), 2, "Removed documents must be counted"s);
+	ASSERT_HINT(server.FindTopDocuments("curly"s).empty() && server.FindTopDocuments("very"s).empty(),
+		"Words of removed documents must not be found"s);
+	server.AddDocument(8, "curly very funny pet"s, DocumentStatus::ACTUAL, { 1 });
+	ASSERT_EQUAL_HINT(server.FindTopDocuments("curly very"s).size(), 1u, "Removed word must be added again"s);
+}
+
+void NearDuplicatesTest() {
+	std::vector<std::string> words;
+	for (int i = 0; i < 60; ++i) {
+		words.push_back("word"s + std::to_string(i));
+	}
+	const auto make_document = [&words](int begin, int end, const std::string& extra_word) {
+		std::string document = extra_word;
+		for (int i = begin; i < end; ++i) {
+			document += " "s + words[i];
+		}
+		return document;
+	};
+	SearchServer server;
+	server.AddDocument(1, make_document(0, 20, "first"s), DocumentStatus::ACTUAL, { 1 });
+	server.AddDocument(2, make_document(20, 40, "second"s), DocumentStatus::ACTUAL, { 1 });
+	//19 of 21 distinct words are common with document 1
+	server.AddDocument(3, make_document(0, 20, "third"s), DocumentStatus::ACTUAL, { 1 });
+	//half of words are common with document 2
+	server.AddDocument(4, make_document(30, 50, "fourth"s), DocumentStatus::ACTUAL, { 1 });
+	server.AddDocument(5, make_document(20, 40, "second"s), DocumentStatus::ACTUAL, { 1 });
+
+	const auto near_duplicates = FindNearDuplicates(server);
+	ASSERT_EQUAL_HINT(near_duplicates.size(), 2u, "Only similar documents must be found"s);
+	ASSERT_HINT(near_duplicates[0].document_id == 3 && near_duplicates[0].original_id == 1
+		&& std::abs(near_duplicates[0].similarity - 20.0 / 22) < 1e-9, "Near copy must be found with its similarity"s);
+	ASSERT_HINT(near_duplicates[1].document_id == 5 && near_duplicates[1].original_id == 2
+		&& near_duplicates[1].similarity == 1.0, "Exact copy must be found"s);
+	ASSERT_EQUAL_HINT(server.GetDocumentCount(), 5, "Report must not change the server"s);
+
+	NearDuplicateOptions options;
+	//low threshold needs short bands, otherwise such pairs rarely become candidates
+	options.similarity_threshold = 0.3;
+	options.band_count = 32;
+	options.rows_per_band = 1;
+	std::ostringstream output;
+	std::streambuf* const cout_buffer = std::cout.rdbuf(output.rdbuf());
+	RemoveNearDuplicates(server, options);
+	std::cout.rdbuf(cout_buffer);
+	ASSERT_EQUAL_HINT(server.GetDocumentCount(), 2, "Near duplicates must be removed"s);
+	ASSERT_HINT(output.str().find("Found near duplicate document id 4\n"s) != std::string::npos,
+		"Removed documents must be reported"s);
+
+	//in chain 1 ~ 2 ~ 3 document 3 is similar only to removed document 2, so it is kept
+	SearchServer chain_server;
+	chain_server.AddDocument(1, make_document(0, 20, ""s), DocumentStatus::ACTUAL, { 1 });
+	chain_server.AddDocument(2, make_document(10, 30, ""s), DocumentStatus::ACTUAL, { 1 });
+	chain_server.AddDocument(3, make_document(20, 40, ""s), DocumentStatus::ACTUAL, { 1 });
+	ASSERT_EQUAL_HINT(FindNearDuplicates(chain_server, options).size(), 2u, "Both pairs of chain must be found"s);
+	output.str(""s);
+	std::cout.rdbuf(output.rdbuf());
+	const auto removed = RemoveNearDuplicates(chain_server, options);
+	std::cout.rdbuf(cout_buffer);
+	ASSERT_HINT(removed.size() == 1 && removed[0].document_id == 2 && removed[0].original_id == 1,
+		"Only document similar to kept one must be removed"s);
+	ASSERT_EQUAL_HINT(output.str(), "Found near duplicate document id 2\n"s, "Only removed document must be reported"s);
+	ASSERT_HINT(chain_server.GetDocumentCount() == 2 && chain_server.FindTopDocuments("word35"s).size() == 1,
+		"Document similar only to removed one must be kept"s);
+
+	options.band_count = 0;
+	try {
+		FindNearDuplicates(server, options);
+		ASSERT_HINT(false, "Bad options must be rejected"s);
+	}
+	catch (const std::invalid_argument&) {
+	}
+}
+
+void MatchDocumentsTest() {
+	SearchServer server("and"s);
+	server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8 });
+	server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::BANNED, { 7 });
+	server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5 });
+	server.AddDocument(4, "fluffy dog with collar"s, DocumentStatus::IRRELEVANT, { 3 });
+	for (const std::string& query : { "fluffy cat collar"s, "cat dog -tail"s, "parrot"s }) {
+		std::vector<DocumentMatch> matches;
+		server.MatchDocuments(query, matches);
+		ASSERT_EQUAL_HINT(matches.size(), 4u, "All documents must be matched"s);
+		for (const DocumentMatch& match : matches) {
+			const auto [words, status] = server.MatchDocument(query, match.id);
+			ASSERT_HINT(match.words == words && match.status == status, "Batch must match as MatchDocument"s);
+		}
+	}
+
+	//buffer is overwritten by the next call
+	std::vector<DocumentMatch> matches;
+	server.MatchDocuments("dog"s, { 4, 1 }, matches);
+	ASSERT_HINT(matches.size() == 2 && matches[0].id == 4 && matches[0].words.size() == 1 && matches[1].words.empty(),
+		"Documents must be matched in order of given ids"s);
+	server.MatchDocuments("collar -white"s, { 1 }, matches);
+	ASSERT_HINT(matches.size() == 1 && matches[0].id == 1 && matches[0].words.empty(), "Minus word must clear matched words"s);
+	try {
+		server.MatchDocuments("dog"s, { 3, 5 }, matches);
+		ASSERT_HINT(false, "Absent document must be rejected"s);
+	}
+	catch (const std::out_of_range&) {
+	}
+}
+
+void DocumentFilterTest() {
+	//bitmap chunk becomes bitmap when it gets dense and array again when it gets sparse
+	SlotBitmap bitmap;
+	for (uint32_t slot = 0; slot < 10000; ++slot) {
+		bitmap.Add(slot * 2);
+	}
+	bitmap.Add(1u << 20);
+	for (uint32_t slot = 0; slot < 9000; ++slot) {
+		bitmap.Remove(slot * 2);
+	}
+	std::vector<uint32_t> slots;
+	bitmap.ForEach([&slots](uint32_t slot) { slots.push_back(slot); });
+	ASSERT_HINT(bitmap.size() == 1001 && slots.size() == 1001 && slots.front() == 18000 && slots.back() == (1u << 20)
+		&& std::is_sorted(slots.begin(), slots.end()), "Wrong slots of bitmap"s);
+	ASSERT_HINT(bitmap.Contains(19998) && !bitmap.Contains(19999) && !bitmap.Contains(2), "Wrong membership in bitmap"s);
+
+	//few banned documents and narrow rating ranges are pushed down, results must be the same as of lambdas
+	SearchServer server;
+	const std::vector<std::string> words = { "cat"s, "dog"s, "fluffy"s, "tail"s, "collar"s, "eyes"s, "bird"s };
+	for (int id = 0; id < 3000; ++id) {
+		std::string document;
+		for (int i = 0; i < 4; ++i) {
+			document += words[(id * (i + 3) + i * i) % words.size()] + " "s;
+		}
+		const DocumentStatus status = id % 20 == 0 ? DocumentStatus::BANNED
+			: id % 20 == 1 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+		server.AddDocument(id, document, status, { id % 100 });
+	}
+	for (int id = 0; id < 3000; id += 7) {
+		server.RemoveDocument(id);
+	}
+	const auto check = [&server](const DocumentFilter& filter, const std::string& hint) {
+		const auto lambda = [&filter](int document_id, DocumentStatus status, int rating) {
+			return filter(document_id, status, rating);
+		};
+		for (const std::string& query : { "cat"s, "fluffy -dog"s, "cat dog tail"s, "bird collar -eyes"s }) {
+			for (const auto& [found, expected] : {
+				std::pair(server.FindTopDocuments(query, filter, 20), server.FindTopDocuments(query, lambda, 20)),
+				std::pair(server.FindTopDocuments(std::execution::par, query, filter, 20),
+					server.FindTopDocuments(std::execution::par, query, lambda, 20)) }) {
+				ASSERT_EQUAL_HINT(found.size(), expected.size(), hint);
+				for (size_t i = 0; i < found.size(); ++i) {
+					ASSERT_HINT(found[i].id == expected[i].id && std::abs(found[i].relevance - expected[i].relevance) < 1e-9, hint);
+				}
+			}
+		}
+	};
+	check(DocumentFilter(DocumentStatus::BANNED), "Status filter must be pushed down"s);
+	check(DocumentFilter().SetStatuses({ DocumentStatus::BANNED, DocumentStatus::IRRELEVANT }), "Set of statuses must be pushed down"s);
+	check(DocumentFilter().SetRatingRange(10, 15), "Rating range must be pushed down"s);
+	check(DocumentFilter(DocumentStatus::ACTUAL).SetRatingRange(90, 1000), "Combined filter must be pushed down"s);
+	check(DocumentFilter(DocumentStatus::ACTUAL), "Wide filter must be checked by postings"s);
+	check(DocumentFilter(DocumentStatus::REMOVED), "Filter passing nothing must find nothing"s);
+	server.CompressPostings();
+	check(DocumentFilter(DocumentStatus::BANNED).SetRatingRange(0, 50), "Filter must be pushed down into compressed postings"s);
+	const auto by_status = server.FindTopDocuments("cat"s, DocumentStatus::BANNED);
+	const auto by_filter = server.FindTopDocuments("cat"s, DocumentFilter(DocumentStatus::BANNED));
+	ASSERT_HINT(!by_status.empty() && std::equal(by_status.begin(), by_status.end(), by_filter.begin(), by_filter.end(),
+		[](const Document& lhs, const Document& rhs) { return lhs.id == rhs.id; }), "Status must be searched as filter"s);
+}
+
+void PredicateKernelsTest() {
+	//kernels specialized for AnyDocument and filters must find the same documents as opaque predicates
+	SearchServer server;
+	const std::vector<std::string> words = { "cat"s, "dog"s, "fluffy"s, "tail"s, "collar"s, "eyes"s, "bird"s, "city"s };
+	for (int id = 0; id < 2000; ++id) {
+		std::string document;
+		for (int i = 0; i < 5; ++i) {
+			document += words[(id * (i + 2) + i * i * 3) % words.size()] + " "s;
+		}
+		server.AddDocument(id, document, static_cast<DocumentStatus>(id % 4), { id % 41 - 20 });
+	}
+	for (int id = 0; id < 2000; id += 9) {
+		server.RemoveDocument(id);
+	}
+	const auto check = [&server](const auto& predicate, const std::string& hint) {
+		const auto lambda = [&predicate](int document_id, DocumentStatus status, int rating) {
+			return predicate(document_id, status, rating);
+		};
+		for (const std::string& query : { "cat"s, "fluffy -dog"s, "cat dog tail eyes"s, "bird collar city -eyes"s }) {
+			for (const auto& [found, expected] : {
+				std::pair(server.FindTopDocuments(query, predicate, 30), server.FindTopDocuments(query, lambda, 30)),
+				std::pair(server.FindTopDocuments(std::execution::par, query, predicate, 30),
+					server.FindTopDocuments(std::execution::par, query, lambda, 30)) }) {
+				ASSERT_EQUAL_HINT(found.size(), expected.size(), hint);
+				for (size_t i = 0; i < found.size(); ++i) {
+					ASSERT_HINT(found[i].id == expected[i].id && found[i].id % 9 != 0, hint);
+				}
+			}
+		}
+	};
+	check(AnyDocument(), "Any document kernel must skip only removed documents"s);
+	check(DocumentFilter(DocumentStatus::IRRELEVANT), "Status kernel must check status codes"s);
+	check(DocumentFilter().SetStatuses({ DocumentStatus::ACTUAL, DocumentStatus::BANNED }).SetRatingRange(-5, 7),
+		"Rating range with negative minimum must be checked"s);
+	check(DocumentFilter().SetRatingRange(std::numeric_limits<int>::min(), -10), "Open rating range must be checked"s);
+	check(DocumentFilter().SetRatingRange(5, -5), "Empty rating range must pass nothing"s);
+	ASSERT_HINT(server.FindTopDocuments("cat"s, DocumentFilter().SetRatingRange(5, -5)).empty(),
+		"Empty rating range must pass nothing"s);
+}
+
 void TestSearchServer() {
 	RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
 	RUN_TEST(TestMinusWords);
@@ -184,4 +1128,26 @@ void TestSearchServer() {
 	RUN_TEST(CustomFiltersTests);
 	RUN_TEST(StatusFilterTest);
 	RUN_TEST(RemoveDocumentTest);
+	RUN_TEST(PostingListTest);
+	RUN_TEST(ResultCountTest);
+	RUN_TEST(ParallelSearchTest);
+	RUN_TEST(ThreadPoolTest);
+	RUN_TEST(TokenizerTest);
+	RUN_TEST(TermStorageCompactionTest);
+	RUN_TEST(AddDocumentsTest);
+	RUN_TEST(SnapshotTest);
+	RUN_TEST(CompressedPostingsTest);
+	RUN_TEST(InverseDocumentFreqCacheTest);
+	RUN_TEST(MaxScoreTest);
+	RUN_TEST(QueryCacheTest);
+	RUN_TEST(ConcurrentSearchServerTest);
+	RUN_TEST(SegmentedIndexTest);
+	RUN_TEST(CorpusGeneratorTest);
+	RUN_TEST(SearchMetricsTest);
+	RUN_TEST(RequestQueueTest);
+	RUN_TEST(RemoveDuplicatesTest);
+	RUN_TEST(NearDuplicatesTest);
+	RUN_TEST(MatchDocumentsTest);
+	RUN_TEST(DocumentFilterTest);
+	RUN_TEST(PredicateKernelsTest);
 }
@@ -2,6 +2,10 @@
 
 #include <string>
 #include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 #define RUN_TEST(function) RunningTest(function);
 #define ASSERT(bool_expression) Assert((bool_expression), (#bool_expression), __FILE__, __LINE__, __FUNCTION__, "");
@@ -10,6 +14,14 @@
 #define ASSERT_EQUAL_HINT(value1, value2, hint) AssertEqual((value1), (value2), (#value1), (#value2), __FILE__, __LINE__, __FUNCTION__, hint);
 
 #include "search_server.h"
+#include "concurrent_search_server.h"
+#include "posting_list.h"
+#include "bit_packing.h"
+#include "benchmark.h"
+#include "thread_pool.h"
+#include "request_queue.h"
+#include "remove_duplicates.h"
+#include "string_processing.h"
 #include "document.h"
 
 using namespace std::string_literals;
@@ -44,5 +56,36 @@ void AverageRatingTest();
 void CustomFiltersTests();
 void StatusFilterTest();
 void RemoveDocumentTest();
+void PostingListTest();
+void ResultCountTest();
+void ParallelSearchTest();
+void ThreadPoolTest();
+void TokenizerTest();
+void TermStorageCompactionTest();
+void AddDocumentsTest();
+void SnapshotTest();
+void CompressedPostingsTest();
+void InverseDocumentFreqCacheTest();
+void MaxScoreTest();
+void QueryCacheTest();
+void ConcurrentSearchServerTest();
+
+void SegmentedIndexTest();
+
+void CorpusGeneratorTest();
+
+void SearchMetricsTest();
+
+void RequestQueueTest();
+
+void RemoveDuplicatesTest();
+
+void NearDuplicatesTest();
+
+void MatchDocumentsTest();
+
+void DocumentFilterTest();
+
+void PredicateKernelsTest();
 
 void TestSearchServer();
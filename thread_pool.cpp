@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+
+#include <chrono>
+
+namespace {
+	//pool and index of the worker running in the current thread, they are set only in worker threads
+	thread_local const ThreadPool* current_pool = nullptr;
+	thread_local size_t current_worker_index = 0;
+}
+
+ThreadPool::ThreadPool(size_t worker_count) {
+	for (size_t index = 0; index < worker_count; ++index) {
+		queues_.push_back(std::make_unique<WorkerQueue>());
+	};
+	for (size_t index = 0; index < worker_count; ++index) {
+		workers_.emplace_back([this, index] { WorkerLoop(index); });
+	};
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard guard(wake_mutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	};
+}
+
+size_t ThreadPool::GetWorkerCount() const {
+	return workers_.size();
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::GetDefault() {
+	static const std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>();
+	return pool;
+}
+
+void ThreadPool::Submit(Task task) {
+	const size_t index = current_pool == this ? current_worker_index : next_queue_++ % queues_.size();
+	{
+		std::lock_guard guard(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	++queued_count_;
+	{
+		//taking the mutex guaranties that sleeping worker will not miss the notification
+		std::lock_guard guard(wake_mutex_);
+	}
+	wake_.notify_one();
+}
+
+bool ThreadPool::TryRunTask() {
+	const size_t own_index = GetOwnQueueIndex();
+	Task task;
+	{
+		//own queue is used as a stack: the latest task is the most likely to have its data in cache
+		WorkerQueue& queue = *queues_[own_index];
+		std::lock_guard guard(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		};
+	}
+	for (size_t shift = 1; !task && shift < queues_.size(); ++shift) {
+		//stealing the oldest task of other queue
+		WorkerQueue& queue = *queues_[(own_index + shift) % queues_.size()];
+		std::lock_guard guard(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		};
+	};
+	if (!task) {
+		return false;
+	};
+	--queued_count_;
+	task();
+	return true;
+}
+
+void ThreadPool::Wait(ForState& state) {
+	while (state.remaining > 0) {
+		if (!TryRunTask()) {
+			//all remaining tasks are executed by other threads, waiting for them
+			std::unique_lock lock(state.mutex);
+			state.finished.wait_for(lock, std::chrono::microseconds(100), [&state] { return state.remaining == 0; });
+		};
+	};
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+	current_pool = this;
+	current_worker_index = index;
+	while (true) {
+		if (TryRunTask()) {
+			continue;
+		};
+		std::unique_lock lock(wake_mutex_);
+		wake_.wait(lock, [this] { return stopping_ || queued_count_ > 0; });
+		if (stopping_ && queued_count_ == 0) {
+			return;
+		};
+	};
+}
+
+size_t ThreadPool::GetOwnQueueIndex() const {
+	return current_pool == this ? current_worker_index : 0;
+}
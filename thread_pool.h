@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//pool of persistent worker threads with work stealing.
+//Every worker has its own queue of tasks: tasks submitted by a worker go to its own queue,
+//tasks submitted by other threads are distributed between queues round robin.
+//Worker takes tasks from the back of its own queue and steals from the front of other queues when it is empty.
+//Thread which waits for its tasks helps executing tasks of the pool, so nested parallel calls do not deadlock
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t worker_count = std::thread::hardware_concurrency());
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool();
+
+	size_t GetWorkerCount() const;
+
+	//calling func(index) for every index in [0, count) in parallel, calling thread executes some of them too.
+	//Returns when all calls are finished, the first exception thrown by func is rethrown
+	template <typename Function>
+	void ParallelFor(size_t count, Function func) {
+		if (count == 0) {
+			return;
+		};
+		if (count == 1 || workers_.empty()) {
+			for (size_t index = 0; index < count; ++index) {
+				func(index);
+			};
+			return;
+		};
+
+		auto state = std::make_shared<ForState>(count);
+		const auto run = [state, &func](size_t index) {
+			try {
+				func(index);
+			}
+			catch (...) {
+				std::lock_guard guard(state->mutex);
+				if (!state->exception) {
+					state->exception = std::current_exception();
+				};
+			};
+			if (--state->remaining == 0) {
+				std::lock_guard guard(state->mutex);
+				state->finished.notify_all();
+			};
+		};
+		for (size_t index = 1; index < count; ++index) {
+			Submit([run, index] { run(index); });
+		};
+		run(0);
+		Wait(*state);
+		if (state->exception) {
+			std::rethrow_exception(state->exception);
+		};
+	}
+
+	//shared pool with one worker for every hardware thread, it is created on the first call
+	static std::shared_ptr<ThreadPool> GetDefault();
+
+private:
+	using Task = std::function<void()>;
+
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	struct ForState {
+		explicit ForState(size_t count) : remaining(count) {}
+
+		std::atomic<size_t> remaining;
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::exception_ptr exception;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues_;
+	std::vector<std::thread> workers_;
+	std::mutex wake_mutex_;
+	std::condition_variable wake_;
+	std::atomic<size_t> queued_count_{ 0 };
+	std::atomic<size_t> next_queue_{ 0 };
+	bool stopping_ = false;
+
+	void Submit(Task task);
+
+	//executing one task from own queue of the worker or stolen from other queues, returns false if there are no tasks
+	bool TryRunTask();
+
+	//executing tasks of the pool until all calls of ParallelFor are finished
+	void Wait(ForState& state);
+
+	void WorkerLoop(size_t index);
+
+	//index of the worker in the pool owning the current thread
+	size_t GetOwnQueueIndex() const;
+};
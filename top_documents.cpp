@@ -0,0 +1,54 @@
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+	if (std::abs(lhs.relevance - rhs.relevance) < MAX_DIFF) {
+		return lhs.rating == rhs.rating ? lhs.id < rhs.id : lhs.rating > rhs.rating;
+	};
+	return lhs.relevance > rhs.relevance;
+}
+
+TopDocuments::TopDocuments(size_t max_count) : max_count_(max_count) {
+	heap_.reserve(std::min<size_t>(max_count, 1024)); //limit can be huge if caller needs all documents
+}
+
+void TopDocuments::Push(const Document& document) {
+	if (max_count_ == 0) {
+		return;
+	};
+	//with IsMoreRelevant as "less" comparator the worst document is on the top of the heap
+	if (heap_.size() < max_count_) {
+		heap_.push_back(document);
+		std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+	}
+	else if (IsMoreRelevant(document, heap_.front())) {
+		std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+		heap_.back() = document;
+		std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+	};
+}
+
+void TopDocuments::Merge(const TopDocuments& other) {
+	for (const Document& document : other.heap_) {
+		Push(document);
+	};
+}
+
+bool TopDocuments::IsFull() const {
+	return heap_.size() >= max_count_;
+}
+
+const Document& TopDocuments::GetWorst() const {
+	return heap_.front();
+}
+
+size_t TopDocuments::size() const {
+	return heap_.size();
+}
+
+std::vector<Document> TopDocuments::Extract() {
+	std::sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+	return std::move(heap_);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "document.h"
+
+const double MAX_DIFF = 1e-6;
+
+//documents are compared by relevance and if relevances are almost the same, then by rating,
+//documents with equal relevance and rating are ordered by id to make result stable
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+//this class keeps only the best documents among all pushed ones, limited by amount set in constructor.
+//Documents are kept in binary heap with the worst of them on the top,
+//so pushing costs O(log k) and there is no need to sort all found documents
+class TopDocuments {
+public:
+	explicit TopDocuments(size_t max_count);
+
+	void Push(const Document& document);
+
+	//pushing all documents kept by other object
+	void Merge(const TopDocuments& other);
+
+	//true if amount of kept documents reached the limit
+	bool IsFull() const;
+
+	//the worst of kept documents, new document must be better than it to be kept
+	const Document& GetWorst() const;
+
+	size_t size() const;
+
+	//returns kept documents sorted from the best to the worst
+	std::vector<Document> Extract();
+
+private:
+	size_t max_count_;
+	std::vector<Document> heap_;
+};